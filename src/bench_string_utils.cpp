@@ -0,0 +1,705 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <string_utils.h>
+
+namespace {
+
+std::atomic<long> allocations(0);
+
+}
+
+// Every allocation made by the library goes through these, so each case can
+// report how many it makes per call.
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size > 0 ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Not inlined, or GCC sees free() called on the result of operator new.
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+bench_clock::duration minimum_time = std::chrono::milliseconds(100);
+
+// Runs f in doubling batches, so that reading the clock does not dominate
+// the cost of very short operations.
+template<typename F>
+double ns_per_op(F f)
+{
+    long ops = 0;
+    const bench_clock::time_point start = bench_clock::now();
+    bench_clock::duration elapsed;
+    for (long batch = 1; ; batch *= 2)
+    {
+        for (long i = 0; i < batch; ++i)
+        {
+            f();
+        }
+        ops += batch;
+        elapsed = bench_clock::now() - start;
+        if (elapsed >= minimum_time)
+        {
+            break;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+}
+
+// Random lower-case text with every occurrence of the needle defused, so the
+// needle only appears once, at the far end from where the search starts.
+std::string make_haystack(std::string::size_type size, std::string_view needle, bool needle_first)
+{
+    std::string haystack;
+    haystack.reserve(size);
+    unsigned seed = 12345;
+    while (haystack.size() < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        haystack.push_back("abcdefghijklmnopqrstuvwxyz "[(seed >> 16) % 27]);
+    }
+    for (std::string::size_type pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos))
+    {
+        haystack[pos] = '_';
+    }
+    if (needle.size() <= size)
+    {
+        haystack.replace(needle_first ? 0 : size - needle.size(), needle.size(), needle);
+    }
+    return haystack;
+}
+
+volatile long sink;
+
+void bench_search(std::string::size_type size, std::string_view needle)
+{
+    const std::string forward = make_haystack(size, needle, false);
+    const std::string backward = make_haystack(size, needle, true);
+    const std::string_view forward_view(forward), backward_view(backward);
+
+    const double baseline = ns_per_op([&] { sink = forward_view.find(needle); });
+    const double kernel = ns_per_op([&] { sink = string_utils::search_helper(forward_view, needle); });
+    const double reverse_baseline = ns_per_op([&] { sink = backward_view.rfind(needle); });
+    const double reverse_kernel = ns_per_op([&] { sink = string_utils::rsearch_helper(backward_view, needle); });
+
+    std::printf("%12zu %8zu %14.1f %14.1f %7.2fx %14.1f %14.1f %7.2fx\n",
+                size, needle.size(),
+                baseline, kernel, baseline / kernel,
+                reverse_baseline, reverse_kernel, reverse_baseline / reverse_kernel);
+}
+
+// One simulated request: split a record, partition each field, rewrite
+// the values and join them back together.
+std::string::size_type handle_request(std::string_view record)
+{
+    const string_utils::string_list fields = string_utils::split(record, ",");
+    string_utils::string_list values;
+    for (const std::string& field : fields)
+    {
+        values.push_back(string_utils::replace(string_utils::partition(field, "=").tail, "_", " "));
+    }
+    return string_utils::join(";", values).size();
+}
+
+std::string::size_type handle_request(std::string_view record, std::pmr::memory_resource* resource)
+{
+    const string_utils::pmr::string_list fields = string_utils::pmr::split(record, ",", resource);
+    string_utils::pmr::string_list values(resource);
+    for (const string_utils::pmr::string& field : fields)
+    {
+        values.push_back(string_utils::pmr::replace(string_utils::pmr::partition(field, "=", resource).tail, "_", " ", resource));
+    }
+    return string_utils::pmr::join(";", values, resource).size();
+}
+
+void bench_allocators(int fields)
+{
+    std::string record;
+    for (int i = 0; i < fields; ++i)
+    {
+        record += (i ? ",field_" : "field_") + std::to_string(i) + "=some_moderately_long_value_" + std::to_string(i);
+    }
+
+    static char buffer[1 << 20];
+    const double baseline = ns_per_op([&] { sink = handle_request(record); });
+    const double arena = ns_per_op([&]
+    {
+        std::pmr::monotonic_buffer_resource resource(buffer, sizeof buffer);
+        sink = handle_request(record, &resource);
+    });
+
+    std::printf("%12d %12zu %14.1f %14.1f %7.2fx\n", fields, record.size(), baseline, arena, baseline / arena);
+}
+
+void bench_batch(unsigned threads, const std::vector<std::string>& inputs, double& single)
+{
+    std::vector<string_utils::string_list> outputs(inputs.size());
+    string_utils::thread_pool pool(threads);
+    const double ns = ns_per_op([&]
+    {
+        string_utils::batch::apply(pool, inputs, outputs,
+                                   string_utils::batch::pipeline(string_utils::batch::strip(),
+                                                                 string_utils::batch::lower(),
+                                                                 string_utils::batch::replace("_", " "),
+                                                                 string_utils::batch::split(",")));
+    }) / inputs.size();
+    if (threads == 1)
+    {
+        single = ns;
+    }
+    std::printf("%12u %14.1f %7.2fx\n", threads, ns, single / ns);
+}
+
+void compare(std::string::size_type max_size)
+{
+    const char* const needles[] = { "ne", "needle", "needle in a haystack, hiding" };
+
+    std::printf("\n%12s %8s %14s %14s %8s %14s %14s %8s\n",
+                "bytes", "needle", "find ns/op", "kernel ns/op", "speedup",
+                "rfind ns/op", "kernel ns/op", "speedup");
+    for (std::string::size_type size = 64; size <= max_size; size *= 16)
+    {
+        for (const char* needle : needles)
+        {
+            bench_search(size, needle);
+        }
+    }
+
+    std::printf("\n%12s %12s %14s %14s %8s\n", "fields", "bytes", "default ns/op", "arena ns/op", "speedup");
+    for (int fields = 1; fields <= 4096; fields *= 8)
+    {
+        bench_allocators(fields);
+    }
+
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 1 << 18; ++i)
+    {
+        inputs.push_back("  Some_Record," + std::to_string(i) + ",FIELD_VALUE  ");
+    }
+    const unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+    double single = 0;
+    std::printf("\n%12s %14s %8s\n", "threads", "batch ns/item", "speedup");
+    for (unsigned threads = 1; threads < max_threads; threads *= 2)
+    {
+        bench_batch(threads, inputs, single);
+    }
+    bench_batch(max_threads, inputs, single);
+}
+
+// Text drawn at random from an alphabet, with "needle," written every
+// hit_every bytes. The alphabets never contain ',' and any accidental
+// "needle" is defused, so a hit_every of 0 gives no matches at all.
+struct profile_t
+{
+    const char* name;
+    const char* alphabet;
+    std::size_t hit_every;
+};
+
+const profile_t profiles[] =
+{
+    { "miss", "abcdefghijklmnopqrstuvwxyz ", 0 },
+    { "sparse", "abcdefghijklmnopqrstuvwxyz ", 4096 },
+    { "dense", "abcdefghijklmnopqrstuvwxyz ", 16 },
+    { "mixed", "abcdEFGH ijkl\tMNOP\nqrst01\xc3\xa9\xe2\x82\xac", 64 },
+};
+
+const std::string_view hit = "needle,";
+const std::string_view needle = "needle";
+const std::string_view separator = ",";
+
+struct bench_input
+{
+    std::string text;
+    std::string scratch;
+    string_utils::string_view_list fields;
+    // A copy of text on disk for mapped_text, written when first needed.
+    std::string path;
+    bool path_current = false;
+};
+
+void make_input(bench_input& input, std::size_t size, const profile_t& profile, bool fields)
+{
+    const std::size_t alphabet_size = std::strlen(profile.alphabet);
+    input.text.clear();
+    input.text.reserve(size);
+    unsigned seed = 12345;
+    while (input.text.size() < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        input.text.push_back(profile.alphabet[(seed >> 16) % alphabet_size]);
+    }
+    for (std::string::size_type pos = input.text.find(needle); pos != std::string::npos; pos = input.text.find(needle, pos))
+    {
+        input.text[pos] = '_';
+    }
+    if (profile.hit_every > 0)
+    {
+        for (std::size_t pos = profile.hit_every - 1; pos + hit.size() <= size; pos += profile.hit_every)
+        {
+            input.text.replace(pos, hit.size(), hit);
+        }
+    }
+    input.scratch = input.text;
+    input.path_current = false;
+    input.fields.clear();
+    if (fields)
+    {
+        input.fields = string_utils::split_view(input.text, separator);
+    }
+}
+
+const std::string& text_file(bench_input& input)
+{
+    if (input.path_current)
+    {
+        return input.path;
+    }
+    if (input.path.empty())
+    {
+        char name[] = "/tmp/bench_string_utils.XXXXXX";
+        const int fd = ::mkstemp(name);
+        if (fd < 0)
+        {
+            std::perror("mkstemp");
+            std::exit(1);
+        }
+        ::close(fd);
+        input.path = name;
+    }
+    std::FILE* out = std::fopen(input.path.c_str(), "wb");
+    if (!out || std::fwrite(input.text.data(), 1, input.text.size(), out) != input.text.size() || std::fclose(out) != 0)
+    {
+        std::perror(input.path.c_str());
+        std::exit(1);
+    }
+    input.path_current = true;
+    return input.path;
+}
+
+// Lets line_reader read text in place rather than from a copy held by a
+// std::istringstream.
+class view_streambuf : public std::streambuf
+{
+public:
+    explicit view_streambuf(std::string_view s)
+    {
+        char* const first = const_cast<char*>(s.data());
+        setg(first, first, first + s.size());
+    }
+};
+
+const string_utils::searcher& needle_searcher()
+{
+    static const string_utils::searcher searcher(needle);
+    return searcher;
+}
+
+const string_utils::replacer& replacements()
+{
+    static const string_utils::replacer replacer({ { "needle", "pin" }, { ",", ";" } });
+    return replacer;
+}
+
+const string_utils::translation& rot13()
+{
+    static const string_utils::translation table = string_utils::maketrans("abcdefghijklmnopqrstuvwxyz",
+                                                                            "nopqrstuvwxyzabcdefghijklm");
+    return table;
+}
+
+string_utils::thread_pool& pool()
+{
+    static string_utils::thread_pool threads;
+    return threads;
+}
+
+typedef long (*bench_op)(bench_input& input);
+
+// Cases that build a container of tokens stop at this size, to bound the
+// memory a 256 MiB input would otherwise need.
+const std::size_t max_list_size = 8 << 20;
+
+struct bench_case
+{
+    const char* name;
+    bench_op op;
+    bool builds_list;
+};
+
+const bench_case cases[] =
+{
+    { "capitalize", [](bench_input& in) -> long { return string_utils::capitalize(in.text).size(); }, false },
+    { "center", [](bench_input& in) -> long { return string_utils::center(in.text, in.text.size() + 16).size(); }, false },
+    { "count", [](bench_input& in) -> long { return string_utils::count(in.text, needle); }, false },
+    { "count (searcher)", [](bench_input& in) -> long { return string_utils::count(in.text, needle_searcher()); }, false },
+    { "count (thread_pool)", [](bench_input& in) -> long { return string_utils::count(pool(), in.text, needle); }, false },
+    { "endswith", [](bench_input& in) -> long { return string_utils::endswith(in.text, needle); }, false },
+    { "expandtabs", [](bench_input& in) -> long { return string_utils::expandtabs(in.text).size(); }, false },
+    { "find", [](bench_input& in) -> long { return string_utils::find(in.text, needle); }, false },
+    { "find (searcher)", [](bench_input& in) -> long { return string_utils::find(in.text, needle_searcher()); }, false },
+    { "find (thread_pool)", [](bench_input& in) -> long { return string_utils::find(pool(), in.text, needle); }, false },
+    { "isalnum", [](bench_input& in) -> long { return string_utils::isalnum(in.text); }, false },
+    { "isalpha", [](bench_input& in) -> long { return string_utils::isalpha(in.text); }, false },
+    { "isdigit", [](bench_input& in) -> long { return string_utils::isdigit(in.text); }, false },
+    { "islower", [](bench_input& in) -> long { return string_utils::islower(in.text); }, false },
+    { "isspace", [](bench_input& in) -> long { return string_utils::isspace(in.text); }, false },
+    { "istitle", [](bench_input& in) -> long { return string_utils::istitle(in.text); }, false },
+    { "isupper", [](bench_input& in) -> long { return string_utils::isupper(in.text); }, false },
+    { "join", [](bench_input& in) -> long { return string_utils::join(separator, in.fields).size(); }, true },
+    { "ljust", [](bench_input& in) -> long { return string_utils::ljust(in.text, in.text.size() + 16).size(); }, false },
+    { "lower", [](bench_input& in) -> long { return string_utils::lower(in.text).size(); }, false },
+    { "lower_inplace", [](bench_input& in) -> long { string_utils::lower_inplace(in.scratch); return in.scratch.size(); }, false },
+    { "line_reader", [](bench_input& in) -> long
+        {
+            view_streambuf buffer(in.text);
+            std::istream stream(&buffer);
+            string_utils::line_reader reader(stream);
+            long lines = 0;
+            for (std::string_view line; reader.next(line); )
+            {
+                ++lines;
+            }
+            return lines;
+        }, false },
+    { "lines_range", [](bench_input& in) -> long
+        {
+            long lines = 0;
+            for (std::string_view line : string_utils::lines_range(in.text))
+            {
+                lines += !line.empty();
+            }
+            return lines;
+        }, false },
+    { "lower (thread_pool)", [](bench_input& in) -> long { return string_utils::lower(pool(), in.text).size(); }, false },
+    { "lstrip", [](bench_input& in) -> long { return string_utils::lstrip(in.text).size(); }, false },
+    { "mapped_text", [](bench_input& in) -> long
+        {
+            const string_utils::mapped_text text(text_file(in));
+            return string_utils::count(text, needle);
+        }, false },
+    { "partition", [](bench_input& in) -> long { return string_utils::partition(in.text, separator).tail.size(); }, false },
+    { "partition_view", [](bench_input& in) -> long { return string_utils::partition_view(in.text, separator).tail.size(); }, false },
+    { "pmr::replace", [](bench_input& in) -> long
+        {
+            std::pmr::monotonic_buffer_resource resource;
+            return string_utils::pmr::replace(in.text, needle, "pin", &resource).size();
+        }, false },
+    { "pmr::split", [](bench_input& in) -> long
+        {
+            std::pmr::monotonic_buffer_resource resource;
+            return string_utils::pmr::split(in.text, separator, &resource).size();
+        }, true },
+    { "replace", [](bench_input& in) -> long { return string_utils::replace(in.text, needle, "pin").size(); }, false },
+    { "replace (searcher)", [](bench_input& in) -> long { return string_utils::replace(in.text, needle_searcher(), "pin").size(); }, false },
+    { "replace (thread_pool)", [](bench_input& in) -> long { return string_utils::replace(pool(), in.text, needle, "pin").size(); }, false },
+    { "replace_many", [](bench_input& in) -> long { return string_utils::replace_many(in.text, replacements()).size(); }, false },
+    { "rfind", [](bench_input& in) -> long { return string_utils::rfind(in.text, needle); }, false },
+    { "rfind (searcher)", [](bench_input& in) -> long { return string_utils::rfind(in.text, needle_searcher()); }, false },
+    { "rjust", [](bench_input& in) -> long { return string_utils::rjust(in.text, in.text.size() + 16).size(); }, false },
+    { "rpartition", [](bench_input& in) -> long { return string_utils::rpartition(in.text, separator).head.size(); }, false },
+    { "rsplit", [](bench_input& in) -> long { return string_utils::rsplit(in.text, separator, 8).size(); }, true },
+    { "rsplit_each", [](bench_input& in) -> long
+        {
+            long tokens = 0;
+            string_utils::rsplit_each(in.text, separator, [&](std::string_view token) { tokens += !token.empty(); });
+            return tokens;
+        }, true },
+    { "rstrip", [](bench_input& in) -> long { return string_utils::rstrip(in.text).size(); }, false },
+    { "split", [](bench_input& in) -> long { return string_utils::split(in.text, separator).size(); }, true },
+    { "split (whitespace)", [](bench_input& in) -> long { return string_utils::split(in.text).size(); }, true },
+    { "split_any", [](bench_input& in) -> long { return string_utils::split_any(in.text, " ,").size(); }, true },
+    { "split_range", [](bench_input& in) -> long
+        {
+            long tokens = 0;
+            for (std::string_view token : string_utils::split_range(in.text, separator))
+            {
+                tokens += !token.empty();
+            }
+            return tokens;
+        }, false },
+    { "split_each", [](bench_input& in) -> long
+        {
+            long tokens = 0;
+            string_utils::split_each(in.text, separator, [&](std::string_view token) { tokens += !token.empty(); });
+            return tokens;
+        }, false },
+    { "split_view", [](bench_input& in) -> long { return string_utils::split_view(in.text, separator).size(); }, true },
+    { "splitlines", [](bench_input& in) -> long { return string_utils::splitlines(in.text).size(); }, true },
+    { "splitlines_each", [](bench_input& in) -> long
+        {
+            long lines = 0;
+            string_utils::splitlines_each(in.text, [&](std::string_view line) { lines += !line.empty(); });
+            return lines;
+        }, false },
+    { "splitlines_view", [](bench_input& in) -> long { return string_utils::splitlines_view(in.text).size(); }, true },
+    { "startswith", [](bench_input& in) -> long { return string_utils::startswith(in.text, needle); }, false },
+    { "strip", [](bench_input& in) -> long { return string_utils::strip(in.text).size(); }, false },
+    { "strip_view", [](bench_input& in) -> long { return string_utils::strip_view(in.text).size(); }, false },
+    { "swapcase", [](bench_input& in) -> long { return string_utils::swapcase(in.text).size(); }, false },
+    { "swapcase_inplace", [](bench_input& in) -> long { string_utils::swapcase_inplace(in.scratch); return in.scratch.size(); }, false },
+    { "table_formatter", [](bench_input& in) -> long
+        {
+            string_utils::column_t name, value;
+            name.width = 16;
+            value.width = 16;
+            value.alignment = string_utils::align_right;
+            string_utils::table_formatter table({ name, value });
+            for (std::string_view field : in.fields)
+            {
+                table.add_row({ field, field });
+            }
+            return table.str().size();
+        }, true },
+    { "tab_expander", [](bench_input& in) -> long
+        {
+            string_utils::tab_expander expander;
+            return expander.expand(in.text).size();
+        }, false },
+    { "title", [](bench_input& in) -> long { return string_utils::title(in.text).size(); }, false },
+    { "translate", [](bench_input& in) -> long { return string_utils::translate(in.text, rot13()).size(); }, false },
+    { "translate_inplace", [](bench_input& in) -> long { string_utils::translate_inplace(in.scratch, rot13()); return in.scratch.size(); }, false },
+    { "translate (thread_pool)", [](bench_input& in) -> long { return string_utils::translate(pool(), in.text, rot13()).size(); }, false },
+    { "upper", [](bench_input& in) -> long { return string_utils::upper(in.text).size(); }, false },
+    { "upper_inplace", [](bench_input& in) -> long { string_utils::upper_inplace(in.scratch); return in.scratch.size(); }, false },
+    { "upper (thread_pool)", [](bench_input& in) -> long { return string_utils::upper(pool(), in.text).size(); }, false },
+    { "whitespace_split_range", [](bench_input& in) -> long
+        {
+            long tokens = 0;
+            for (std::string_view token : string_utils::whitespace_split_range(in.text))
+            {
+                tokens += !token.empty();
+            }
+            return tokens;
+        }, false },
+    { "zfill", [](bench_input& in) -> long { return string_utils::zfill(in.text, in.text.size() + 16).size(); }, false },
+};
+
+struct result_t
+{
+    std::string function;
+    std::string profile;
+    std::size_t bytes;
+    double ns_per_op;
+    double bytes_per_s;
+    double allocs_per_op;
+};
+
+std::string result_key(const std::string& function, const std::string& profile, std::size_t bytes)
+{
+    return function + '/' + profile + '/' + std::to_string(bytes);
+}
+
+// Reads back a file written by write_json(); anything else is ignored.
+std::map<std::string, result_t> read_json(const char* path)
+{
+    std::map<std::string, result_t> results;
+    std::FILE* in = std::fopen(path, "r");
+    if (!in)
+    {
+        return results;
+    }
+    char line[512];
+    while (std::fgets(line, sizeof line, in))
+    {
+        char function[128], profile[64];
+        result_t result;
+        if (std::sscanf(line, " {\"function\": \"%127[^\"]\", \"profile\": \"%63[^\"]\", \"bytes\": %zu, \"ns_per_op\": %lf, \"bytes_per_s\": %lf, \"allocs_per_op\": %lf",
+                        function, profile, &result.bytes, &result.ns_per_op, &result.bytes_per_s, &result.allocs_per_op) == 6)
+        {
+            result.function = function;
+            result.profile = profile;
+            results[result_key(function, profile, result.bytes)] = result;
+        }
+    }
+    std::fclose(in);
+    return results;
+}
+
+bool write_json(const char* path, const std::vector<result_t>& results)
+{
+    std::FILE* out = std::fopen(path, "w");
+    if (!out)
+    {
+        return false;
+    }
+    std::fprintf(out, "[\n");
+    for (std::vector<result_t>::size_type i = 0; i < results.size(); ++i)
+    {
+        const result_t& result = results[i];
+        std::fprintf(out, "  {\"function\": \"%s\", \"profile\": \"%s\", \"bytes\": %zu, \"ns_per_op\": %.3f, \"bytes_per_s\": %.1f, \"allocs_per_op\": %.2f}%s\n",
+                     result.function.c_str(), result.profile.c_str(), result.bytes,
+                     result.ns_per_op, result.bytes_per_s, result.allocs_per_op,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "]\n");
+    return std::fclose(out) == 0;
+}
+
+void usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--max-size BYTES] [--min-time MS] [--filter TEXT]\n"
+                 "       [--json FILE] [--baseline FILE] [--compare]\n",
+                 program);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t max_size = 256 << 20;
+    const char* filter = "";
+    const char* json = 0;
+    const char* baseline_path = 0;
+    bool comparisons = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view option = argv[i];
+        if (option == "--compare")
+        {
+            comparisons = true;
+        }
+        else if (i + 1 < argc && option == "--max-size")
+        {
+            max_size = std::strtoull(argv[++i], 0, 10);
+        }
+        else if (i + 1 < argc && option == "--min-time")
+        {
+            minimum_time = std::chrono::milliseconds(std::strtol(argv[++i], 0, 10));
+        }
+        else if (i + 1 < argc && option == "--filter")
+        {
+            filter = argv[++i];
+        }
+        else if (i + 1 < argc && option == "--json")
+        {
+            json = argv[++i];
+        }
+        else if (i + 1 < argc && option == "--baseline")
+        {
+            baseline_path = argv[++i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    const std::map<std::string, result_t> baseline = baseline_path ? read_json(baseline_path) : std::map<std::string, result_t>();
+    if (baseline_path && baseline.empty())
+    {
+        std::printf("No results in baseline %s; run with --json %s to save one.\n\n", baseline_path, baseline_path);
+    }
+
+    std::printf("%-24s %-8s %10s %14s %12s %10s", "function", "profile", "bytes", "ns/op", "MB/s", "allocs/op");
+    if (!baseline.empty())
+    {
+        std::printf(" %8s", "vs base");
+    }
+    std::printf("\n");
+
+    std::vector<result_t> results;
+    int slower = 0, more_allocations = 0;
+    bench_input input;
+    for (std::size_t size = 8; size <= max_size; size *= 32)
+    {
+        for (const profile_t& profile : profiles)
+        {
+            make_input(input, size, profile, size <= max_list_size);
+            for (const bench_case& c : cases)
+            {
+                if ((c.builds_list && size > max_list_size) || !std::strstr(c.name, filter))
+                {
+                    continue;
+                }
+
+                // Count allocations on the second call, once function-local
+                // statics such as the thread_pool exist.
+                sink = c.op(input);
+                const long before = allocations.load();
+                sink = c.op(input);
+                const long allocated = allocations.load() - before;
+
+                result_t result;
+                result.function = c.name;
+                result.profile = profile.name;
+                result.bytes = size;
+                result.ns_per_op = ns_per_op([&] { sink = c.op(input); });
+                result.bytes_per_s = size / result.ns_per_op * 1e9;
+                result.allocs_per_op = allocated;
+                results.push_back(result);
+
+                std::printf("%-24s %-8s %10zu %14.1f %12.1f %10.2f", c.name, profile.name, size,
+                            result.ns_per_op, result.bytes_per_s / 1e6, result.allocs_per_op);
+                const std::map<std::string, result_t>::const_iterator base = baseline.find(result_key(c.name, profile.name, size));
+                if (base != baseline.end())
+                {
+                    // Allocation counts are exact, so any increase is a
+                    // regression; timings are noisy, so allow 10%.
+                    const bool is_slower = result.ns_per_op > base->second.ns_per_op * 1.1;
+                    const bool allocates_more = result.allocs_per_op > base->second.allocs_per_op;
+                    slower += is_slower;
+                    more_allocations += allocates_more;
+                    std::printf(" %7.2fx%s%s", base->second.ns_per_op / result.ns_per_op,
+                                is_slower ? " slower" : "", allocates_more ? " allocs" : "");
+                }
+                std::printf("\n");
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    if (!input.path.empty())
+    {
+        std::remove(input.path.c_str());
+    }
+
+    if (json && !write_json(json, results))
+    {
+        std::perror(json);
+        return 1;
+    }
+
+    if (!baseline.empty())
+    {
+        std::printf("\n%d results more than 10%% slower than the baseline, %d with more allocations.\n",
+                    slower, more_allocations);
+    }
+
+    if (comparisons)
+    {
+        compare(max_size);
+    }
+    return more_allocations > 0 ? 1 : 0;
+}
@@ -0,0 +1,698 @@
+#include "string_utils.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace string_utils {
+
+std::string_view::size_type search_helper(std::string_view s, std::string_view needle, std::string_view::size_type pos)
+{
+    const std::string_view::size_type length = s.length(), needle_length = needle.length();
+    if (pos > length || needle_length > length - pos)
+    {
+        return std::string_view::npos;
+    }
+    if (needle_length == 0)
+    {
+        return pos;
+    }
+
+    const char* const haystack = s.data();
+    if (needle_length == 1)
+    {
+        const void* found = std::memchr(haystack + pos, needle[0], length - pos);
+        return found ? static_cast<const char*>(found) - haystack : std::string_view::npos;
+    }
+
+#ifdef STRING_UTILS_SIMD
+    const simd::block first = simd::splat(needle[0]);
+    const simd::block last = simd::splat(needle[needle_length - 1]);
+    for (; pos + needle_length - 1 + simd::width <= length; pos += simd::width)
+    {
+        unsigned candidates = simd::eq_mask(simd::load(haystack + pos), first)
+            & simd::eq_mask(simd::load(haystack + pos + needle_length - 1), last);
+        for (; candidates != 0; candidates &= candidates - 1)
+        {
+            const std::string_view::size_type candidate = pos + __builtin_ctz(candidates);
+            if (search_verify_helper(haystack + candidate, needle))
+            {
+                return candidate;
+            }
+        }
+    }
+#endif
+    return s.find(needle, pos);
+}
+
+std::string_view::size_type rsearch_helper(std::string_view s, std::string_view needle, std::string_view::size_type pos)
+{
+    const std::string_view::size_type length = s.length(), needle_length = needle.length();
+    if (needle_length > length)
+    {
+        return std::string_view::npos;
+    }
+
+    const std::string_view::size_type last_start = std::min(pos, length - needle_length);
+    if (needle_length == 0)
+    {
+        return last_start;
+    }
+
+    std::string_view::size_type end = last_start + 1;
+#ifdef STRING_UTILS_SIMD
+    const char* const haystack = s.data();
+    const simd::block first = simd::splat(needle[0]);
+    const simd::block last = simd::splat(needle[needle_length - 1]);
+    for (; end >= simd::width; end -= simd::width)
+    {
+        const std::string_view::size_type block_start = end - simd::width;
+        unsigned candidates = simd::eq_mask(simd::load(haystack + block_start), first)
+            & simd::eq_mask(simd::load(haystack + block_start + needle_length - 1), last);
+        while (candidates != 0)
+        {
+            const unsigned bit = std::numeric_limits<unsigned>::digits - 1 - __builtin_clz(candidates);
+            if (search_verify_helper(haystack + block_start + bit, needle))
+            {
+                return block_start + bit;
+            }
+            candidates &= ~(1U << bit);
+        }
+    }
+#endif
+    return end == 0 ? std::string_view::npos : s.rfind(needle, end - 1);
+}
+
+std::string pad_helper(std::string_view s, int width, char fill, alignment_t alignment)
+{
+    std::string out;
+    out.reserve(std::max<std::ptrdiff_t>(width, s.length()));
+    pad_helper(out, s, width, fill, alignment);
+    return out;
+}
+
+void center_inplace(std::string& s, int width, char fill)
+{
+    const int padding = width - s.length();
+    if (padding > 0)
+    {
+        const int before = padding / 2;
+        const int after = padding - before;
+        s.reserve(width);
+        s.insert(0, before, fill);
+        s.append(after, fill);
+    }
+}
+
+bool endswith(std::string_view s, std::string_view suffix, std::ptrdiff_t start, std::ptrdiff_t end)
+{
+    end = std::min<std::ptrdiff_t>(end, s.size());
+    const std::ptrdiff_t chars_from_end = s.size() - end;
+    return start <= end
+        && (end - start >= static_cast<std::ptrdiff_t>(suffix.length()))
+        && std::equal(suffix.rbegin(), suffix.rend(), s.rbegin() + chars_from_end);
+}
+
+std::string_view::size_type find_bytes_helper(std::string_view s, std::string_view::size_type pos, char a, char b, char c)
+{
+    const std::string_view::size_type length = s.length();
+#ifdef STRING_UTILS_SIMD
+    const simd::block splat_a = simd::splat(a), splat_b = simd::splat(b), splat_c = simd::splat(c);
+    for (; pos + simd::width <= length; pos += simd::width)
+    {
+        const simd::block block = simd::load(s.data() + pos);
+        const unsigned found = simd::eq_mask(block, splat_a) | simd::eq_mask(block, splat_b) | simd::eq_mask(block, splat_c);
+        if (found != 0)
+        {
+            return pos + __builtin_ctz(found);
+        }
+    }
+#endif
+    for (; pos < length; ++pos)
+    {
+        if (a == s[pos] || b == s[pos] || c == s[pos])
+        {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+std::string::size_type expandtabs_size_helper(std::string_view s, int tabsize, std::size_t& column)
+{
+    std::string::size_type size = 0;
+    for (std::string_view::size_type pos = 0; pos < s.length();)
+    {
+        const std::string_view::size_type special = find_bytes_helper(s, pos, '\t', '\n', '\r');
+        const std::string_view::size_type run = (special == std::string_view::npos ? s.length() : special) - pos;
+        size += run;
+        column += run;
+        if (special == std::string_view::npos)
+        {
+            break;
+        }
+
+        if ('\t' == s[special])
+        {
+            const std::size_t fill = tab_fill_helper(column, tabsize);
+            size += fill;
+            column += fill;
+        }
+        else
+        {
+            ++size;
+            column = 0;
+        }
+        pos = special + 1;
+    }
+    return size;
+}
+
+char* expandtabs_helper(const char* first, const char* last, char* out, int tabsize, std::size_t& column)
+{
+    const std::string_view s(first, last - first);
+    for (std::string_view::size_type pos = 0; pos < s.length();)
+    {
+        const std::string_view::size_type special = find_bytes_helper(s, pos, '\t', '\n', '\r');
+        const std::string_view::size_type run = (special == std::string_view::npos ? s.length() : special) - pos;
+        std::memmove(out, first + pos, run);
+        out += run;
+        column += run;
+        if (special == std::string_view::npos)
+        {
+            break;
+        }
+
+        if ('\t' == s[special])
+        {
+            const std::size_t fill = tab_fill_helper(column, tabsize);
+            out = std::fill_n(out, fill, ' ');
+            column += fill;
+        }
+        else
+        {
+            *out++ = s[special];
+            column = 0;
+        }
+        pos = special + 1;
+    }
+    return out;
+}
+
+std::string expandtabs(const std::string& s, int tabsize)
+{
+    std::size_t column = 0;
+    std::string copy(expandtabs_size_helper(s, tabsize, column), '\0');
+    column = 0;
+    expandtabs_helper(s.data(), s.data() + s.length(), &copy[0], tabsize, column);
+    return copy;
+}
+
+void expandtabs_inplace(std::string& s, int tabsize)
+{
+    std::size_t column = 0;
+    const std::string::size_type length = s.length(), expanded = expandtabs_size_helper(s, tabsize, column);
+    column = 0;
+    if (expanded <= length)
+    {
+        expandtabs_helper(s.data(), s.data() + length, &s[0], tabsize, column);
+        s.resize(expanded);
+        return;
+    }
+
+    s.resize(expanded);
+    char* const buffer = &s[0];
+    std::memmove(buffer + expanded - length, buffer, length);
+    expandtabs_helper(buffer + expanded - length, buffer + expanded, buffer, tabsize, column);
+}
+
+std::ptrdiff_t index(std::string_view s, std::string_view substring, std::ptrdiff_t start, std::ptrdiff_t end)
+{
+    std::ptrdiff_t index = find(s, substring, start, end);
+    if (index < 0)
+    {
+        throw value_error("substring not found");
+    }
+    return index;
+}
+
+bool all_ascii_class_helper(std::string_view s, unsigned char ascii_class)
+{
+    if (s.empty())
+    {
+        return false;
+    }
+
+    std::string_view::size_type i = 0;
+#ifdef STRING_UTILS_SIMD
+    for (; i + simd::width <= s.length(); i += simd::width)
+    {
+        const simd::block b = simd::load(s.data() + i);
+        simd::block in = simd::splat(0);
+        if (ascii_class & ascii_digit)
+        {
+            in = simd::bit_or(in, simd::in_range(b, '0', '9'));
+        }
+        if (ascii_class & ascii_lower)
+        {
+            in = simd::bit_or(in, simd::in_range(b, 'a', 'z'));
+        }
+        if (ascii_class & ascii_upper)
+        {
+            in = simd::bit_or(in, simd::in_range(b, 'A', 'Z'));
+        }
+        if (ascii_class & ascii_space)
+        {
+            in = simd::bit_or(in, simd::bit_or(simd::in_range(b, '\t', '\r'), simd::in_range(b, ' ', ' ')));
+        }
+        if (simd::high_mask(in) != simd::all_lanes)
+        {
+            return false;
+        }
+    }
+#endif
+    for (; i < s.length(); ++i)
+    {
+        if (!is_ascii_class_helper(s[i], ascii_class))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool istitle(std::string_view s)
+{
+    bool follows_cased = false;
+    bool has_uppercase = false;
+    bool istitle = true;
+
+    for (std::string_view::const_iterator current = s.begin(), end = s.end(); istitle && current != end; ++current)
+    {
+        if (is_ascii_class_helper(*current, ascii_lower))
+        {
+            if (!follows_cased)
+            {
+                istitle = false;
+            }
+            follows_cased = true;
+        }
+        else if (is_ascii_class_helper(*current, ascii_upper))
+        {
+            if (follows_cased)
+            {
+                istitle = false;
+            }
+            follows_cased = true;
+            has_uppercase = true;
+        }
+        else
+        {
+            follows_cased = false;
+        }
+    }
+    return istitle && has_uppercase;
+}
+
+void case_helper(std::string_view s, char* out, bool flip_lower, bool flip_upper, char (*fallback)(char))
+{
+    std::string_view::size_type i = 0;
+#ifdef STRING_UTILS_SIMD
+    const simd::block case_bit = simd::splat('a' ^ 'A');
+    for (; i + simd::width <= s.length(); i += simd::width)
+    {
+        const simd::block b = simd::load(s.data() + i);
+        if (simd::high_mask(b) != 0)
+        {
+            std::transform(s.data() + i, s.data() + i + simd::width, out + i, fallback);
+            continue;
+        }
+
+        simd::block flip = simd::splat(0);
+        if (flip_lower)
+        {
+            flip = simd::bit_or(flip, simd::in_range(b, 'a', 'z'));
+        }
+        if (flip_upper)
+        {
+            flip = simd::bit_or(flip, simd::in_range(b, 'A', 'Z'));
+        }
+        simd::store(out + i, simd::bit_xor(b, simd::bit_and(flip, case_bit)));
+    }
+#else
+    static_cast<void>(flip_lower);
+    static_cast<void>(flip_upper);
+#endif
+    std::transform(s.data() + i, s.data() + s.length(), out + i, fallback);
+}
+
+std::string lower(const std::string& s)
+{
+    std::string lowercased(s.length(), '\0');
+    case_helper(s, &lowercased[0], false, true, lower_helper);
+    return lowercased;
+}
+
+void assign_view_helper(std::string& s, std::string_view view)
+{
+    const std::string::size_type offset = view.data() - s.data();
+    s.erase(offset + view.length());
+    s.erase(0, offset);
+}
+
+partition_t partition_helper(const partition_view_t& partitioned)
+{
+    partition_t copied = {
+        std::string(partitioned.head),
+        std::string(partitioned.sep),
+        std::string(partitioned.tail)
+    };
+    return copied;
+}
+
+std::ptrdiff_t rindex(std::string_view s, std::string_view substring, std::ptrdiff_t start, std::ptrdiff_t end)
+{
+    std::ptrdiff_t index = rfind(s, substring, start, end);
+    if (index < 0)
+    {
+        throw value_error("substring not found");
+    }
+    return index;
+}
+
+void rjust_inplace(std::string& s, int width, char fillchar)
+{
+    int fillsize = width - s.length();
+    if (fillsize > 0)
+    {
+        s.insert(0, fillsize, fillchar);
+    }
+}
+
+string_list split_helper(std::string_view s)
+{
+    string_list result;
+    split_helper(s, std::back_inserter(result));
+    return result;
+}
+
+string_list rsplit(std::string_view s, std::string_view sep, std::ptrdiff_t max_split)
+{
+    string_list result;
+    rsplit(s, sep, std::back_inserter(result), max_split);
+    return result;
+}
+
+string_list rsplit(std::string_view s, const searcher& sep, std::ptrdiff_t max_split)
+{
+    string_list result;
+    rsplit(s, sep, std::back_inserter(result), max_split);
+    return result;
+}
+
+string_list split(std::string_view s, std::string_view sep, std::ptrdiff_t max_split)
+{
+    string_list result;
+    split(s, sep, std::back_inserter(result), max_split);
+    return result;
+}
+
+string_list split(std::string_view s, const searcher& sep, std::ptrdiff_t max_split)
+{
+    string_list result;
+    split(s, sep, std::back_inserter(result), max_split);
+    return result;
+}
+
+string_list splitlines(std::string_view s, bool keepends)
+{
+    string_list result;
+    splitlines(s, std::back_inserter(result), keepends);
+    return result;
+}
+
+bool line_reader::next(std::string_view& line)
+{
+    for (;;)
+    {
+        const std::string_view pending(buffer_.data() + begin_, end_ - begin_);
+        const std::string_view::size_type new_line = newline_helper(pending, scanned_ - begin_);
+        // A "\r" at the end of the buffer may be the first half of "\r\n".
+        if (new_line != std::string_view::npos && (pending[new_line] == '\n' || new_line + 1 < pending.length() || eof_))
+        {
+            std::string_view::size_type newline_size = 1;
+            if ('\r' == pending[new_line] && new_line + 1 < pending.length() && '\n' == pending[new_line + 1])
+            {
+                newline_size = 2;
+            }
+            line = pending.substr(0, new_line + (keepends_ ? newline_size : 0));
+            begin_ = scanned_ = begin_ + new_line + newline_size;
+            return true;
+        }
+
+        if (eof_)
+        {
+            if (pending.empty())
+            {
+                return false;
+            }
+            line = pending;
+            begin_ = scanned_ = end_;
+            return true;
+        }
+
+        scanned_ = new_line == std::string_view::npos ? end_ : begin_ + new_line;
+        fill();
+    }
+}
+
+void line_reader::fill()
+{
+    if (begin_ > 0)
+    {
+        std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    }
+    end_ -= begin_;
+    scanned_ -= begin_;
+    begin_ = 0;
+    if (buffer_.size() < end_ + chunk_size_)
+    {
+        buffer_.resize(end_ + chunk_size_);
+    }
+
+    const std::size_t count = read(buffer_.data() + end_, chunk_size_);
+    end_ += count;
+    eof_ = count == 0;
+}
+
+std::size_t line_reader::read(char* out, std::size_t count)
+{
+    if (in_)
+    {
+        in_->read(out, count);
+        return in_->gcount();
+    }
+
+    for (;;)
+    {
+        const ssize_t result = ::read(fd_, out, count);
+        if (result >= 0)
+        {
+            return result;
+        }
+        if (errno != EINTR)
+        {
+            throw std::system_error(errno, std::generic_category(), "line_reader");
+        }
+    }
+}
+
+mapped_text::mapped_text(const std::string& path)
+    :data_(0), size_(0), mapped_(false), contents_()
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0)
+    {
+        void* const mapping = ::mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            ::madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(mapping);
+            size_ = status.st_size;
+            mapped_ = true;
+            ::close(fd);
+            return;
+        }
+    }
+
+    try
+    {
+        read_all(fd);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+mapped_text::~mapped_text()
+{
+    if (mapped_)
+    {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void mapped_text::read_all(int fd)
+{
+    char buffer[64 * 1024];
+    for (;;)
+    {
+        const ssize_t count = ::read(fd, buffer, sizeof buffer);
+        if (count > 0)
+        {
+            contents_.append(buffer, count);
+        }
+        else if (count == 0)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            throw std::system_error(errno, std::generic_category(), "mapped_text");
+        }
+    }
+    data_ = contents_.data();
+    size_ = contents_.size();
+}
+
+std::string swapcase(const std::string& s)
+{
+    std::string swapcased(s.length(), '\0');
+    case_helper(s, &swapcased[0], true, true, swapcase_helper);
+    return swapcased;
+}
+
+std::string title(const std::string& s)
+{
+    std::string titlecased(s);
+    title_inplace(titlecased);
+    return titlecased;
+}
+
+std::string translate(const std::string& s, const std::string& translation_table, const std::string& delete_chars)
+{
+    std::string copy(s);
+    translate_inplace(copy, translation_table, delete_chars);
+    return copy;
+}
+
+std::string upper(const std::string& s)
+{
+    std::string uppercased(s.length(), '\0');
+    case_helper(s, &uppercased[0], true, false, upper_helper);
+    return uppercased;
+}
+
+thread_pool::thread_pool(unsigned threads, std::size_t grain)
+    :grain_(grain > 0 ? grain : 1), mutex_(), wake_(), tasks_(), workers_(), stopping_(false)
+{
+    for (unsigned i = 1; i < threads; ++i)
+    {
+        workers_.emplace_back([this] { work(); });
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void thread_pool::work()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+            {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+std::vector<std::size_t> chunk_bounds_helper(const thread_pool& pool, std::size_t length)
+{
+    const std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(pool.size(), length / pool.grain()));
+    std::vector<std::size_t> bounds(chunks + 1);
+    for (std::size_t i = 0; i <= chunks; ++i)
+    {
+        bounds[i] = length / chunks * i + length % chunks * i / chunks;
+    }
+    return bounds;
+}
+
+std::string translate(thread_pool& pool, std::string_view s, const translation& table)
+{
+    std::string out(s.length(), '\0');
+    char* const data = &out[0];
+    const std::vector<std::size_t> bounds = chunk_bounds_helper(pool, s.length());
+    std::vector<std::size_t> ends(bounds.size() - 1);
+    pool.run(ends.size(), [&](std::size_t i)
+    {
+        ends[i] = table.apply(s.data() + bounds[i], s.data() + bounds[i + 1], data + bounds[i]) - data;
+    });
+
+    std::size_t write = ends[0];
+    for (std::size_t i = 1; i < ends.size(); ++i)
+    {
+        if (write != bounds[i])
+        {
+            std::memmove(data + write, data + bounds[i], ends[i] - bounds[i]);
+        }
+        write += ends[i] - bounds[i];
+    }
+    out.resize(write);
+    return out;
+}
+
+namespace pmr {
+
+partition_t partition_helper(const partition_view_t& partitioned, std::pmr::memory_resource* resource)
+{
+    partition_t copied = {
+        string(partitioned.head, resource),
+        string(partitioned.sep, resource),
+        string(partitioned.tail, resource)
+    };
+    return copied;
+}
+
+}
+
+}
@@ -1,9 +1,39 @@
 #ifndef STRING_UTILS_H
 #define STRING_UTILS_H
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <exception>
+#include <functional>
+#include <initializer_list>
+#include <istream>
+#include <iterator>
 #include <limits>
+#include <list>
+#include <locale>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace string_utils {
 
@@ -29,516 +59,3301 @@ private:
 };
 
 typedef std::list<std::string> string_list;
+typedef std::vector<std::string_view> string_view_list;
+
+const std::ptrdiff_t max_pos = std::numeric_limits<std::ptrdiff_t>::max();
 
-const int max_pos = std::numeric_limits<int>::max();
-const int max_count = max_pos;
+// A count or max_split of max_count, or of any negative value, means no
+// limit, as in Python.
+const std::ptrdiff_t max_count = -1;
 
-std::string capitalize(std::string copy)
+constexpr std::ptrdiff_t limit_helper(std::ptrdiff_t count)
 {
-    copy[0] = ::toupper(copy[0]);
-    return copy;
+    return count < 0 ? max_pos : count;
 }
 
-std::string center(const std::string& s, int width, char fill = ' ')
+namespace simd {
+
+// Each instruction set gets its own inline namespace, so code built with
+// -mavx2 can link against a library built without it.
+#if defined(__AVX2__)
+#define STRING_UTILS_SIMD 1
+inline namespace avx2 {
+
+typedef __m256i block;
+const std::size_t width = 32;
+
+inline block load(const char* p)
 {
-    const int padding = width - s.length();
-    if (padding > 0)
-    {
-        const int before = padding / 2;
-        const int after = padding - before;
-        return std::string(before, fill) + s + std::string(after, fill);
-    }
-    return s;
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
 }
 
-int count(const std::string& s, const std::string& substring, int start = 0, int end = max_pos)
+inline block splat(char ch)
 {
-    int count = 0;
-    for (int pos = s.find(substring, start);
-         start <= pos && pos < end;
-         pos = s.find(substring, pos + substring.size()))
-    {
-        ++count;
-    }
-    return count;
+    return _mm256_set1_epi8(ch);
 }
 
-bool endswith(const std::string& s, const std::string& suffix, int start = 0, int end = max_pos)
+inline unsigned eq_mask(block a, block b)
 {
-    if (end == max_pos)
-    {
-        end = s.size();
-    }
-    const int chars_from_end = s.size() - end;
-    return (end - start >= static_cast<int>(suffix.length()))
-        && std::equal(suffix.rbegin(), suffix.rend(), s.rbegin() + chars_from_end);
+    return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
 }
 
-std::string expandtabs(const std::string& s, int tabsize = 8)
+inline void store(char* p, block b)
 {
-    std::string copy = "";
-    int pos_in_line = 0;
-
-    for (std::string::const_iterator current = s.begin(), end = s.end(); current != end; ++current)
-    {
-        switch (*current)
-        {
-            case '\n':
-            case '\r':
-                copy.push_back(*current);
-                pos_in_line = 0;
-                break;
-            case '\t':
-                if (tabsize > 0)
-                {
-                    int fillsize = tabsize - (pos_in_line % tabsize);
-                    copy.append(std::string(fillsize, ' '));
-                    pos_in_line += fillsize;
-                }
-                break;
-            default:
-                copy.push_back(*current);
-                ++pos_in_line;
-        }
-    }
-    return copy;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), b);
 }
 
-int find(const std::string& s, const std::string& substring, int start = 0, int end = max_pos)
+inline unsigned high_mask(block b)
 {
-    int index = s.find(substring, start);
-    if (end < index + static_cast<int>(substring.size()))
-    {
-        index = -1;
-    }
-    return index;
+    return static_cast<unsigned>(_mm256_movemask_epi8(b));
 }
 
-int index(const std::string& s, const std::string& substring, int start = 0, int end = max_pos)
+inline block greater(block a, block b)
 {
-    int index = find(s, substring, start, end);
-    if (index < 0)
-    {
-        throw value_error("substring not found");
-    }
-    return index;
+    return _mm256_cmpgt_epi8(a, b);
 }
 
-bool isalnum(const std::string& s)
+inline block bit_and(block a, block b)
 {
-    return !s.empty()
-        && std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun(::isalnum))) == s.end();
+    return _mm256_and_si256(a, b);
 }
 
-bool isalpha(const std::string& s)
+inline block bit_or(block a, block b)
 {
-    return !s.empty()
-        && std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun(::isalpha))) == s.end();
+    return _mm256_or_si256(a, b);
 }
 
-bool isdigit(const std::string& s)
+inline block bit_xor(block a, block b)
 {
-    return !s.empty()
-        && std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun(::isdigit))) == s.end();
+    return _mm256_xor_si256(a, b);
 }
 
-bool islower(const std::string& s)
-{
-    return !s.empty()
-        && std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun(::islower))) == s.end();
 }
+#elif defined(__SSE2__)
+#define STRING_UTILS_SIMD 1
+inline namespace sse2 {
 
-bool isspace(const std::string& s)
+typedef __m128i block;
+const std::size_t width = 16;
+
+inline block load(const char* p)
 {
-    return !s.empty()
-        && std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun(::isspace))) == s.end();
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
 }
 
-bool istitle(const std::string& s)
+inline block splat(char ch)
 {
-    bool follows_cased = false;
-    bool has_uppercase = false;
-    bool istitle = true;
-
-    for (std::string::const_iterator current = s.begin(), end = s.end(); istitle && current != end; ++current)
-    {
-        if (::islower(*current))
-        {
-            if (!follows_cased)
-            {
-                istitle = false;
-            }
-            follows_cased = true;
-        }
-        else if (::isupper(*current))
-        {
-            if (follows_cased)
-            {
-                istitle = false;
-            }
-            follows_cased = true;
-            has_uppercase = true;
-        }
-        else
-        {
-            follows_cased = false;
-        }
-    }
-    return istitle && has_uppercase;
+    return _mm_set1_epi8(ch);
 }
 
-bool isupper(const std::string& s)
+inline unsigned eq_mask(block a, block b)
 {
-    return !s.empty()
-        && std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun(::isupper))) == s.end();
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
 }
 
-template<typename C>
-std::string join(const std::string& s, C container)
+inline void store(char* p, block b)
 {
-    std::ostringstream joined;
-    typename C::const_iterator current = container.begin(), end = container.end();
-    joined << *current;
-    for (++current; current != end; ++current)
-    {
-        joined << s;
-        joined << *current;
-    }
-
-    return joined.str();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), b);
 }
 
-template<>
-std::string join(const std::string& s, const char* buffer)
+inline unsigned high_mask(block b)
 {
-    return join(s, std::string(buffer));
+    return static_cast<unsigned>(_mm_movemask_epi8(b));
 }
 
-std::string ljust(std::string copy, int width, char fillchar = ' ')
+inline block greater(block a, block b)
 {
-    int fillsize = width - copy.length();
-    if (fillsize > 0)
-    {
-        copy.append(std::string(fillsize, fillchar));
-    }
-    return copy;
+    return _mm_cmpgt_epi8(a, b);
 }
 
-std::string lower(const std::string& s)
+inline block bit_and(block a, block b)
 {
-    std::string lowercased;
-    std::transform(s.begin(), s.end(), back_inserter(lowercased), ::tolower);
-    return lowercased;
+    return _mm_and_si128(a, b);
 }
 
-std::string lstrip(const std::string& s, const char* chars = " \t\r\n")
+inline block bit_or(block a, block b)
 {
-    std::string::size_type begin = s.find_first_not_of(chars);
-    if (begin == std::string::npos)
-    {
-        return "";
-    }
-    return std::string(s, begin);
+    return _mm_or_si128(a, b);
 }
 
-std::string rstrip(const std::string& s, const char* chars = " \t\r\n")
+inline block bit_xor(block a, block b)
 {
-    std::string::size_type end = s.find_last_not_of(chars);
-    return std::string(s, 0, end + 1);
+    return _mm_xor_si128(a, b);
 }
 
-std::string strip(const std::string& s)
-{
-    return lstrip(rstrip(s));
 }
+#endif
 
-struct partition_t
-{
-    std::string head, sep, tail;
-};
+#ifdef STRING_UTILS_SIMD
+const unsigned all_lanes = static_cast<unsigned>((1ULL << width) - 1);
 
-partition_t partition_helper(const std::string& s, const std::string& sep, const int pos)
+// Bytes are compared as signed, so those at or above 0x80 are never in an
+// ASCII range.
+inline block in_range(block b, char first, char last)
 {
-    if (pos < 0)
-    {
-        partition_t partitioned = { s, "", "" };
-        return partitioned;
-    }
+    return bit_and(greater(b, splat(first - 1)), greater(splat(last + 1), b));
+}
+#endif
 
-    partition_t partitioned = {
-        std::string(s, 0, pos),
-        sep,
-        std::string(s, pos + sep.length())
-    };
-    return partitioned;
 }
 
-partition_t partition(const std::string& s, const std::string& sep)
+inline bool search_verify_helper(const char* candidate, std::string_view needle)
 {
-    return partition_helper(s, sep, s.find(sep));
+    return needle.length() < 3
+        || std::memcmp(candidate + 1, needle.data() + 1, needle.length() - 2) == 0;
 }
 
-std::string replace(std::string copy, const std::string& old, const std::string& with, int count = max_count)
+// Equivalent to s.find(needle, pos). Candidates are positions whose first
+// and last bytes both match the needle's, found a SIMD block at a time and
+// then verified with memcmp().
+std::string_view::size_type search_helper(std::string_view s, std::string_view needle, std::string_view::size_type pos = 0);
+
+// Equivalent to s.rfind(needle, pos), scanning blocks from the back.
+std::string_view::size_type rsearch_helper(std::string_view s, std::string_view needle, std::string_view::size_type pos = std::string_view::npos);
+
+// A needle preprocessed once for the Two-Way algorithm (Crochemore & Perrin),
+// giving O(n) worst-case searches, plus a last-byte shift table that lets
+// typical searches skip ahead. Copies share the preprocessed state.
+class searcher
 {
-    const int old_length = old.length(), with_length = with.length();
-    for (int pos = copy.find(old);
-         pos >= 0 && count > 0;
-         pos = copy.find(old, pos + with_length))
+public:
+    typedef std::string_view::size_type size_type;
+
+    searcher()
+        :state_()
     {
-        copy.replace(pos, old_length, with);
-        --count;
     }
-    return copy;
-}
 
-int rfind(const std::string& s, const std::string& substring, int start = 0, int end = max_pos)
-{
-    int pos = s.rfind(substring, end);
-    if (start > pos
-        || pos > end - static_cast<int>(substring.length()))
+    explicit searcher(std::string_view needle)
+        :state_(std::make_shared<const state>(needle))
     {
-        pos = -1;
     }
-    return pos;
-}
 
-int rindex(const std::string& s, const std::string& substring, int start = 0, int end = max_pos)
-{
-    int index = rfind(s, substring, start, end);
-    if (index < 0)
+    std::string_view needle() const
     {
-        throw value_error("substring not found");
+        return state_ ? std::string_view(state_->needle) : std::string_view();
     }
-    return index;
-}
 
-std::string rjust(const std::string& s, int width, char fillchar = ' ')
-{
-    std::string out;
-    int fillsize = width - s.length();
-    if (fillsize > 0)
+    size_type length() const
     {
-        out = std::string(fillsize, fillchar);
+        return needle().length();
     }
-    return out + s;;
-}
-
-partition_t rpartition(const std::string& s, const std::string& sep)
-{
-    return partition_helper(s, sep, s.rfind(sep));
-}
 
-string_list split_helper(const std::string& s)
-{
-    string_list split;
-    const std::string stripped = strip(s);
-    std::string::const_iterator end_of_space = stripped.begin();
-    std::string::const_iterator end_of_string = stripped.end();
-    std::string::const_iterator next_space = std::find_if(stripped.begin(), end_of_string, std::ptr_fun(::isspace));
-    for (;
-         next_space != end_of_string;
-         next_space = std::find_if(end_of_space, end_of_string, std::ptr_fun(::isspace)))
+    size_type find_in(std::string_view s, size_type pos = 0) const
     {
-        split.push_back(std::string(end_of_space, next_space));
-        end_of_space = std::find_if(next_space, end_of_string, std::not1(std::ptr_fun(::isspace)));
+        const size_type length = s.length(), needle_length = this->length();
+        if (pos > length || needle_length > length - pos)
+        {
+            return std::string_view::npos;
+        }
+        if (needle_length == 0)
+        {
+            return pos;
+        }
+
+        const size_type found = search(state_->forward, state_->needle.data(), needle_length, s.data() + pos, length - pos);
+        return found == std::string_view::npos ? found : pos + found;
     }
-    if (end_of_space != next_space)
+
+    size_type rfind_in(std::string_view s, size_type pos = std::string_view::npos) const
     {
-        split.push_back(std::string(end_of_space, next_space));
+        const size_type length = s.length(), needle_length = this->length();
+        if (needle_length > length)
+        {
+            return std::string_view::npos;
+        }
+
+        const size_type last_start = std::min(pos, length - needle_length);
+        if (needle_length == 0)
+        {
+            return last_start;
+        }
+
+        const size_type region = last_start + needle_length;
+        const size_type found = search(state_->backward, state_->reversed.data(), needle_length, reversed_text(s.data() + region), region);
+        return found == std::string_view::npos ? found : region - found - needle_length;
     }
-    return split;
-}
 
-string_list rsplit(const std::string& s)
-{
-    return split_helper(s);
-}
+private:
+    struct factorization
+    {
+        size_type suffix, period;
+        bool periodic;
+        size_type shift[std::numeric_limits<unsigned char>::max() + 1];
+    };
 
-string_list rsplit(const std::string& s, const std::string& sep, int max_split = max_count)
-{
-    if (sep.empty())
+    struct state
     {
-        throw value_error("empty separator");
-    }
+        explicit state(std::string_view s)
+            :needle(s), reversed(s.rbegin(), s.rend()), forward(factorize(needle)), backward(factorize(reversed))
+        {
+        }
+
+        const std::string needle, reversed;
+        const factorization forward, backward;
+    };
 
-    string_list split;
-    const int sep_length = sep.length();
-    int last_pos = s.length();
-    int pos = s.rfind(sep);
-    for (;
-         pos > 0 && max_split > 0;
-         pos = s.rfind(sep, last_pos - 1))
+    struct reversed_text
     {
-        split.push_front(std::string(s, pos + sep_length, last_pos - pos - sep_length));
-        last_pos = pos;
-        --max_split;
+        explicit reversed_text(const char* end)
+            :end_(end)
+        {
+        }
+
+        char operator[](size_type i) const
+        {
+            return *(end_ - 1 - i);
+        }
+
+        const char* end_;
+    };
+
+    static void maximal_suffix(std::string_view needle, bool reverse_order, size_type& suffix, size_type& period)
+    {
+        size_type max_suffix = std::string_view::npos, j = 0, k = 1, p = 1;
+        while (j + k < needle.length())
+        {
+            const unsigned char a = needle[j + k], b = needle[max_suffix + k];
+            if (reverse_order ? b < a : a < b)
+            {
+                j += k;
+                k = 1;
+                p = j - max_suffix;
+            }
+            else if (a == b)
+            {
+                if (k != p)
+                {
+                    ++k;
+                }
+                else
+                {
+                    j += p;
+                    k = 1;
+                }
+            }
+            else
+            {
+                max_suffix = j++;
+                k = p = 1;
+            }
+        }
+        suffix = max_suffix + 1;
+        period = p;
     }
 
-    if (0 == pos)
+    static factorization factorize(std::string_view needle)
     {
-        split.push_front(std::string(s, sep_length, last_pos));
-        split.push_front("");
+        factorization f = factorization();
+        size_type suffix_reversed, period_reversed;
+        maximal_suffix(needle, false, f.suffix, f.period);
+        maximal_suffix(needle, true, suffix_reversed, period_reversed);
+        if (suffix_reversed > f.suffix)
+        {
+            f.suffix = suffix_reversed;
+            f.period = period_reversed;
+        }
+
+        f.periodic = f.suffix + f.period <= needle.length()
+            && needle.compare(0, f.suffix, needle, f.period, f.suffix) == 0;
+        if (!f.periodic)
+        {
+            f.period = std::max(f.suffix, needle.length() - f.suffix) + 1;
+        }
+
+        std::fill(f.shift, f.shift + sizeof(f.shift) / sizeof(f.shift[0]), needle.length());
+        for (size_type i = 0; i < needle.length(); ++i)
+        {
+            f.shift[static_cast<unsigned char>(needle[i])] = needle.length() - 1 - i;
+        }
+        return f;
     }
-    else
+
+    // Returns the first position of needle[0, m) in haystack[0, n), where
+    // 0 < m <= n, or npos.
+    template<typename Text>
+    static size_type search(const factorization& f, const char* needle, size_type m, const Text& haystack, size_type n)
     {
-        split.push_front(std::string(s, 0, last_pos));
+        size_type j = 0, memory = 0;
+        while (j <= n - m)
+        {
+            size_type shift = f.shift[static_cast<unsigned char>(haystack[j + m - 1])];
+            if (shift > 0)
+            {
+                if (memory > 0 && shift < f.period)
+                {
+                    shift = m - f.period;
+                }
+                memory = 0;
+                j += shift;
+                continue;
+            }
+
+            size_type i = std::max(f.suffix, memory);
+            while (i < m - 1 && needle[i] == haystack[i + j])
+            {
+                ++i;
+            }
+            if (i < m - 1)
+            {
+                j += i - f.suffix + 1;
+                memory = 0;
+                continue;
+            }
+
+            i = f.suffix;
+            while (i > memory && needle[i - 1] == haystack[i - 1 + j])
+            {
+                --i;
+            }
+            if (i <= memory)
+            {
+                return j;
+            }
+            j += f.period;
+            memory = f.periodic ? m - f.period : 0;
+        }
+        return std::string_view::npos;
     }
-    return split;
-}
 
-string_list split(const std::string& s)
+    std::shared_ptr<const state> state_;
+};
+
+inline std::string_view::size_type search_helper(std::string_view s, const searcher& needle, std::string_view::size_type pos = 0)
 {
-    return split_helper(s);
+    return needle.find_in(s, pos);
 }
 
-string_list split(const std::string& s, const std::string& sep, int max_split = max_count)
+inline std::string_view::size_type rsearch_helper(std::string_view s, const searcher& needle, std::string_view::size_type pos = std::string_view::npos)
 {
-    if (sep.empty())
-    {
-        throw value_error("empty separator");
-    }
+    return needle.rfind_in(s, pos);
+}
 
-    string_list split;
-    const int sep_length = sep.length();
-    int last_pos = 0;
-    for (int pos = s.find(sep);
-         pos >= 0 && max_split > 0;
-         pos = s.find(sep, last_pos))
-    {
-        split.push_back(std::string(s, last_pos, pos - last_pos));
-        last_pos = pos + sep_length;
-        --max_split;
-    }
-    if (0 == last_pos)
-    {
-        split.push_back("");
-    }
-    else
-    {
-        split.push_back(std::string(s, last_pos));
-    }
-    return split;
+inline std::string capitalize(std::string copy)
+{
+    copy[0] = ::toupper(copy[0]);
+    return copy;
 }
 
-bool isnewline(char ch)
+enum alignment_t
 {
-    return '\r' == ch || '\n' == ch;
+    align_left,
+    align_right,
+    align_center
+};
+
+// The padding rules shared by ljust, rjust, center, zfill, table_formatter
+// and the fixed_string versions: s is never truncated, and center puts any
+// odd fill character after s.
+constexpr std::ptrdiff_t pad_before_helper(std::ptrdiff_t padding, alignment_t alignment)
+{
+    return alignment == align_left ? 0 : alignment == align_right ? padding : padding / 2;
 }
 
-string_list splitlines(const std::string& s, bool keepends = false)
+template<typename String>
+void pad_helper(String& out, std::string_view s, int width, char fill, alignment_t alignment)
 {
-    string_list split;
-    std::string::const_iterator start_of_line = s.begin();
-    std::string::const_iterator end_of_line = s.end();
-    std::string::const_iterator new_line = std::find_if(s.begin(), end_of_line, std::ptr_fun(isnewline));
-    for (;
-         new_line != end_of_line;
-         new_line = std::find_if(start_of_line, end_of_line, std::ptr_fun(isnewline)))
+    const std::ptrdiff_t padding = width - static_cast<std::ptrdiff_t>(s.length());
+    if (padding <= 0)
     {
-        int newline_size = 1;
-        if ('\r' == *new_line && '\n' == *(new_line + 1))
-        {
-            newline_size = 2;
-        }
-        split.push_back(std::string(start_of_line, new_line + (keepends ? newline_size : 0)));
-        start_of_line = new_line + newline_size;
+        out.append(s);
+        return;
     }
-    return split;
+
+    const std::ptrdiff_t before = pad_before_helper(padding, alignment);
+    out.append(before, fill);
+    out.append(s);
+    out.append(padding - before, fill);
 }
 
-bool startswith(const std::string& s, const std::string& prefix, int start = 0, int end = max_pos)
+std::string pad_helper(std::string_view s, int width, char fill, alignment_t alignment);
+
+inline std::string center(const std::string& s, int width, char fill = ' ')
 {
-    return (end - start >= static_cast<int>(prefix.length()))
-        && std::equal(prefix.begin(), prefix.end(), s.begin() + start);
+    return pad_helper(s, width, fill, align_center);
 }
 
-char swapcase_helper(char ch)
+void center_inplace(std::string& s, int width, char fill = ' ');
+
+inline std::string center(std::string&& s, int width, char fill = ' ')
 {
-    if (::islower(ch))
-    {
-        ch = ::toupper(ch);
-    }
-    else if (::isupper(ch))
+    center_inplace(s, width, fill);
+    return std::move(s);
+}
+
+template<typename Substring>
+std::ptrdiff_t count_helper(std::string_view s, const Substring& substring, std::ptrdiff_t start, std::ptrdiff_t end)
+{
+    std::ptrdiff_t count = 0;
+    for (std::ptrdiff_t pos = search_helper(s, substring, start);
+         start <= pos && pos < end;
+         pos = search_helper(s, substring, pos + std::max<std::size_t>(substring.length(), 1)))
     {
-        ch = ::tolower(ch);
+        ++count;
     }
-    return ch;
+    return count;
 }
 
-std::string swapcase(const std::string& s)
+inline std::ptrdiff_t count(std::string_view s, std::string_view substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos)
 {
-    std::string swapcased;
-    std::transform(s.begin(), s.end(), back_inserter(swapcased), swapcase_helper);
-    return swapcased;
+    return count_helper(s, substring, start, end);
 }
 
-struct titlecase_helper
+inline std::ptrdiff_t count(std::string_view s, const searcher& substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos)
 {
-    titlecase_helper()
-        :uppercase_next_(true)
-    {
-    }
+    return count_helper(s, substring, start, end);
+}
 
-    char operator()(const char& ch)
-    {
-        char out = ch;
-        if (::isalpha(ch))
-        {
-            if (uppercase_next_)
-            {
-                out = ::toupper(ch);
-                uppercase_next_ = false;
-            }
-            else
-            {
-                out = ::tolower(ch);
-            }
-        }
-        else
-        {
-            uppercase_next_ = true;
-        }
-        return out;
-    }
+bool endswith(std::string_view s, std::string_view suffix, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos);
 
-    bool uppercase_next_;
-};
+// The first of a, b or c at or after pos, a SIMD block at a time.
+std::string_view::size_type find_bytes_helper(std::string_view s, std::string_view::size_type pos, char a, char b, char c);
 
-std::string title(const std::string& s)
+inline std::size_t tab_fill_helper(std::size_t column, int tabsize)
 {
-    std::string titlecased;
-    std::transform(s.begin(), s.end(), back_inserter(titlecased), titlecase_helper());
-    return titlecased;
+    return tabsize > 0 ? tabsize - column % tabsize : 0;
 }
 
-std::string translate(const std::string& s, const std::string& translation_table, const std::string& delete_chars = "")
+// Both passes jump from one tab or line ending to the next, carrying the
+// column in and out so that a stream can be expanded a chunk at a time.
+std::string::size_type expandtabs_size_helper(std::string_view s, int tabsize, std::size_t& column);
+
+// Writes the expansion of [first, last) to out and returns the end of the
+// output. out may point into the input as long as it never gets ahead of
+// first, which holds when it starts at or before first and the expansion is
+// no shorter than what is left.
+char* expandtabs_helper(const char* first, const char* last, char* out, int tabsize, std::size_t& column);
+
+std::string expandtabs(const std::string& s, int tabsize = 8);
+
+void expandtabs_inplace(std::string& s, int tabsize = 8);
+
+// Expands tabs in a stream given a chunk at a time, carrying the column
+// from the end of one chunk to the start of the next.
+class tab_expander
 {
-    if (translation_table.length() != 256)
+public:
+    explicit tab_expander(int tabsize = 8)
+        :tabsize_(tabsize), column_(0)
     {
-        throw value_error("translation table must be 256 characters long");
     }
 
-    std::string out;
-    for (std::string::const_iterator current = s.begin(), end = s.end(); current != end; ++current)
+    // Appends the expansion of chunk to out.
+    void expand(std::string_view chunk, std::string& out)
     {
-        if (std::find(delete_chars.begin(), delete_chars.end(), *current) == delete_chars.end())
-        {
-            out.push_back(translation_table[*current]);
-        }
+        std::size_t column = column_;
+        const std::string::size_type offset = out.length();
+        out.resize(offset + expandtabs_size_helper(chunk, tabsize_, column));
+        expandtabs_helper(chunk.data(), chunk.data() + chunk.length(), &out[offset], tabsize_, column_);
     }
-    return out;
-}
 
-std::string upper(const std::string& s)
-{
-    std::string uppercased;
-    std::transform(s.begin(), s.end(), back_inserter(uppercased), ::toupper);
+    std::string expand(std::string_view chunk)
+    {
+        std::string out;
+        expand(chunk, out);
+        return out;
+    }
+
+    std::size_t column() const
+    {
+        return column_;
+    }
+
+    void reset()
+    {
+        column_ = 0;
+    }
+
+private:
+    int tabsize_;
+    std::size_t column_;
+};
+
+inline std::string expandtabs(std::string&& s, int tabsize = 8)
+{
+    expandtabs_inplace(s, tabsize);
+    return std::move(s);
+}
+
+template<typename Substring>
+std::ptrdiff_t find_helper(std::string_view s, const Substring& substring, std::ptrdiff_t start, std::ptrdiff_t end)
+{
+    std::ptrdiff_t index = search_helper(s, substring, start);
+    if (end < index + static_cast<std::ptrdiff_t>(substring.length()))
+    {
+        index = -1;
+    }
+    return index;
+}
+
+inline std::ptrdiff_t find(std::string_view s, std::string_view substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos)
+{
+    return find_helper(s, substring, start, end);
+}
+
+inline std::ptrdiff_t find(std::string_view s, const searcher& substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos)
+{
+    return find_helper(s, substring, start, end);
+}
+
+std::ptrdiff_t index(std::string_view s, std::string_view substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos);
+
+enum ascii_class_t
+{
+    ascii_digit = 1,
+    ascii_lower = 2,
+    ascii_upper = 4,
+    ascii_space = 8,
+    ascii_alpha = ascii_lower | ascii_upper,
+    ascii_alnum = ascii_digit | ascii_alpha
+};
+
+struct ascii_class_table_t
+{
+    constexpr ascii_class_table_t()
+        : classes()
+    {
+        for (int ch = '0'; ch <= '9'; ++ch)
+        {
+            classes[ch] = ascii_digit;
+        }
+        for (int ch = 'a'; ch <= 'z'; ++ch)
+        {
+            classes[ch] = ascii_lower;
+            classes[ch - 'a' + 'A'] = ascii_upper;
+        }
+        for (int ch = '\t'; ch <= '\r'; ++ch)
+        {
+            classes[ch] = ascii_space;
+        }
+        classes[' '] = ascii_space;
+    }
+
+    unsigned char classes[std::numeric_limits<unsigned char>::max() + 1];
+};
+
+constexpr ascii_class_table_t ascii_class_table;
+
+inline bool is_ascii_class_helper(char ch, unsigned char ascii_class)
+{
+    return (ascii_class_table.classes[static_cast<unsigned char>(ch)] & ascii_class) != 0;
+}
+
+// Locale-independent: only ASCII bytes are classified, as in the "C"
+// locale. Whole SIMD blocks are checked against the class's byte ranges.
+bool all_ascii_class_helper(std::string_view s, unsigned char ascii_class);
+
+inline bool is_locale_helper(std::string_view s, std::ctype_base::mask mask, const std::locale& loc)
+{
+    return !s.empty()
+        && std::use_facet<std::ctype<char> >(loc).scan_not(mask, s.data(), s.data() + s.length()) == s.data() + s.length();
+}
+
+inline bool isalnum(std::string_view s)
+{
+    return all_ascii_class_helper(s, ascii_alnum);
+}
+
+inline bool isalnum(std::string_view s, const std::locale& loc)
+{
+    return is_locale_helper(s, std::ctype_base::alnum, loc);
+}
+
+inline bool isalpha(std::string_view s)
+{
+    return all_ascii_class_helper(s, ascii_alpha);
+}
+
+inline bool isalpha(std::string_view s, const std::locale& loc)
+{
+    return is_locale_helper(s, std::ctype_base::alpha, loc);
+}
+
+inline bool isdigit(std::string_view s)
+{
+    return all_ascii_class_helper(s, ascii_digit);
+}
+
+inline bool isdigit(std::string_view s, const std::locale& loc)
+{
+    return is_locale_helper(s, std::ctype_base::digit, loc);
+}
+
+inline bool islower(std::string_view s)
+{
+    return all_ascii_class_helper(s, ascii_lower);
+}
+
+inline bool islower(std::string_view s, const std::locale& loc)
+{
+    return is_locale_helper(s, std::ctype_base::lower, loc);
+}
+
+inline bool isspace(std::string_view s)
+{
+    return all_ascii_class_helper(s, ascii_space);
+}
+
+inline bool isspace(std::string_view s, const std::locale& loc)
+{
+    return is_locale_helper(s, std::ctype_base::space, loc);
+}
+
+bool istitle(std::string_view s);
+
+inline bool isupper(std::string_view s)
+{
+    return all_ascii_class_helper(s, ascii_upper);
+}
+
+inline bool isupper(std::string_view s, const std::locale& loc)
+{
+    return is_locale_helper(s, std::ctype_base::upper, loc);
+}
+
+template<typename T>
+struct is_string_like_helper
+    : std::integral_constant<bool, std::is_convertible<const T&, std::string_view>::value
+                                   || std::is_same<T, char>::value>
+{
+};
+
+template<typename T>
+std::string_view join_item_helper(const T& item)
+{
+    if constexpr (std::is_same<T, char>::value)
+    {
+        return std::string_view(&item, 1);
+    }
+    else
+    {
+        return std::string_view(item);
+    }
+}
+
+// String-like items are measured first so that the result is allocated
+// once; anything else is formatted with operator<<.
+template<typename String, typename C>
+void join_helper(String& out, std::string_view s, const C& container)
+{
+    typedef typename C::const_iterator const_iterator;
+    typedef typename std::iterator_traits<const_iterator>::value_type value_type;
+    const_iterator current = container.begin(), end = container.end();
+    if (current == end)
+    {
+        return;
+    }
+
+    if constexpr (is_string_like_helper<value_type>::value)
+    {
+        typename String::size_type size = join_item_helper(*current).length();
+        for (const_iterator next = std::next(current); next != end; ++next)
+        {
+            size += s.length() + join_item_helper(*next).length();
+        }
+        out.reserve(out.length() + size);
+
+        out.append(join_item_helper(*current));
+        for (++current; current != end; ++current)
+        {
+            out.append(s);
+            out.append(join_item_helper(*current));
+        }
+    }
+    else
+    {
+        std::ostringstream joined;
+        joined << *current;
+        for (++current; current != end; ++current)
+        {
+            joined << s << *current;
+        }
+        out.append(joined.str());
+    }
+}
+
+template<typename C>
+std::string join(std::string_view s, const C& container)
+{
+    std::string joined;
+    join_helper(joined, s, container);
+    return joined;
+}
+
+inline std::string join(std::string_view s, const char* buffer)
+{
+    return join(s, std::string_view(buffer));
+}
+
+inline std::string ljust(const std::string& s, int width, char fillchar = ' ')
+{
+    return pad_helper(s, width, fillchar, align_left);
+}
+
+inline void ljust_inplace(std::string& s, int width, char fillchar = ' ')
+{
+    if (width > static_cast<int>(s.length()))
+    {
+        s.append(width - s.length(), fillchar);
+    }
+}
+
+inline std::string ljust(std::string&& s, int width, char fillchar = ' ')
+{
+    ljust_inplace(s, width, fillchar);
+    return std::move(s);
+}
+
+inline char lower_helper(char ch)
+{
+    return ::tolower(static_cast<unsigned char>(ch));
+}
+
+inline char upper_helper(char ch)
+{
+    return ::toupper(static_cast<unsigned char>(ch));
+}
+
+// Writes s to out with the case of ASCII letters flipped: a-z if
+// flip_lower, A-Z if flip_upper. Blocks containing any byte >= 0x80 go
+// through the locale-aware fallback instead. Defined in the library, so
+// that its SIMD width is the library's and not the caller's.
+void case_helper(std::string_view s, char* out, bool flip_lower, bool flip_upper, char (*fallback)(char));
+
+std::string lower(const std::string& s);
+
+inline void lower_inplace(std::string& s)
+{
+    case_helper(s, &s[0], false, true, lower_helper);
+}
+
+inline std::string lower(std::string&& s)
+{
+    lower_inplace(s);
+    return std::move(s);
+}
+
+// A set of bytes held as a 256-bit bitmap, so membership is one bit test
+// however many characters the set has.
+class charset
+{
+public:
+    constexpr charset()
+        :bits_()
+    {
+    }
+
+    constexpr charset(const char* chars)
+        :bits_()
+    {
+        for (; *chars != '\0'; ++chars)
+        {
+            add(*chars);
+        }
+    }
+
+    constexpr explicit charset(std::string_view chars)
+        :bits_()
+    {
+        for (std::string_view::size_type i = 0; i < chars.length(); ++i)
+        {
+            add(chars[i]);
+        }
+    }
+
+    constexpr bool contains(char ch) const
+    {
+        const unsigned char byte = ch;
+        return (bits_[byte >> 6] >> (byte & 63)) & 1;
+    }
+
+    constexpr bool empty() const
+    {
+        return (bits_[0] | bits_[1] | bits_[2] | bits_[3]) == 0;
+    }
+
+private:
+    constexpr void add(char ch)
+    {
+        const unsigned char byte = ch;
+        bits_[byte >> 6] |= std::uint64_t(1) << (byte & 63);
+    }
+
+    std::uint64_t bits_[4];
+};
+
+constexpr charset strip_chars(" \t\r\n");
+
+constexpr std::string_view lstrip_view(std::string_view s, const charset& chars = strip_chars)
+{
+    std::string_view::size_type begin = 0;
+    while (begin < s.length() && chars.contains(s[begin]))
+    {
+        ++begin;
+    }
+    return s.substr(begin);
+}
+
+constexpr std::string_view rstrip_view(std::string_view s, const charset& chars = strip_chars)
+{
+    std::string_view::size_type end = s.length();
+    while (end > 0 && chars.contains(s[end - 1]))
+    {
+        --end;
+    }
+    return s.substr(0, end);
+}
+
+// Trims both ends in one pass over each end, without an intermediate view.
+constexpr std::string_view strip_view(std::string_view s, const charset& chars = strip_chars)
+{
+    std::string_view::size_type begin = 0, end = s.length();
+    while (begin < end && chars.contains(s[begin]))
+    {
+        ++begin;
+    }
+    while (end > begin && chars.contains(s[end - 1]))
+    {
+        --end;
+    }
+    return s.substr(begin, end - begin);
+}
+
+void assign_view_helper(std::string& s, std::string_view view);
+
+inline std::string lstrip(const std::string& s, const charset& chars = strip_chars)
+{
+    return std::string(lstrip_view(s, chars));
+}
+
+inline void lstrip_inplace(std::string& s, const charset& chars = strip_chars)
+{
+    assign_view_helper(s, lstrip_view(s, chars));
+}
+
+inline std::string lstrip(std::string&& s, const charset& chars = strip_chars)
+{
+    lstrip_inplace(s, chars);
+    return std::move(s);
+}
+
+inline std::string rstrip(const std::string& s, const charset& chars = strip_chars)
+{
+    return std::string(rstrip_view(s, chars));
+}
+
+inline void rstrip_inplace(std::string& s, const charset& chars = strip_chars)
+{
+    assign_view_helper(s, rstrip_view(s, chars));
+}
+
+inline std::string rstrip(std::string&& s, const charset& chars = strip_chars)
+{
+    rstrip_inplace(s, chars);
+    return std::move(s);
+}
+
+inline std::string strip(const std::string& s, const charset& chars = strip_chars)
+{
+    return std::string(strip_view(s, chars));
+}
+
+inline void strip_inplace(std::string& s, const charset& chars = strip_chars)
+{
+    assign_view_helper(s, strip_view(s, chars));
+}
+
+inline std::string strip(std::string&& s, const charset& chars = strip_chars)
+{
+    strip_inplace(s, chars);
+    return std::move(s);
+}
+
+struct partition_t
+{
+    std::string head, sep, tail;
+};
+
+struct partition_view_t
+{
+    std::string_view head, sep, tail;
+};
+
+template<typename Separator>
+partition_view_t partition_view_helper(std::string_view s, const Separator& sep, std::string_view::size_type pos)
+{
+    if (pos == std::string_view::npos)
+    {
+        partition_view_t partitioned = { s, std::string_view(), std::string_view() };
+        return partitioned;
+    }
+
+    partition_view_t partitioned = {
+        s.substr(0, pos),
+        s.substr(pos, sep.length()),
+        s.substr(pos + sep.length())
+    };
+    return partitioned;
+}
+
+partition_t partition_helper(const partition_view_t& partitioned);
+
+inline partition_view_t partition_view(std::string_view s, std::string_view sep)
+{
+    return partition_view_helper(s, sep, search_helper(s, sep));
+}
+
+inline partition_view_t partition_view(std::string_view s, const searcher& sep)
+{
+    return partition_view_helper(s, sep, search_helper(s, sep));
+}
+
+inline partition_t partition(std::string_view s, std::string_view sep)
+{
+    return partition_helper(partition_view(s, sep));
+}
+
+inline partition_t partition(std::string_view s, const searcher& sep)
+{
+    return partition_helper(partition_view(s, sep));
+}
+
+// Walks s as replace() does, handing emit each piece of the result in
+// order: the runs of s between matches, and with in place of each match
+// that find(from) reports. An empty old string matches between every
+// character, as in Python.
+template<typename Find, typename Emit>
+constexpr void replace_pieces_helper(std::string_view s, std::string_view::size_type old_length, std::string_view with, std::ptrdiff_t count, Find find, Emit emit)
+{
+    count = limit_helper(count);
+    std::string_view::size_type read = 0;
+    if (old_length == 0)
+    {
+        for (; read <= s.length() && count > 0; ++read, --count)
+        {
+            emit(with);
+            if (read < s.length())
+            {
+                emit(s.substr(read, 1));
+            }
+        }
+        read = std::min(read, s.length());
+    }
+    else
+    {
+        for (; count > 0; --count)
+        {
+            const std::string_view::size_type pos = find(read);
+            if (pos == std::string_view::npos)
+            {
+                break;
+            }
+            emit(s.substr(read, pos - read));
+            emit(with);
+            read = pos + old_length;
+        }
+    }
+    emit(s.substr(read));
+}
+
+// A replacement shorter than a non-empty old is compacted into copy's own
+// buffer; otherwise the result is measured first so that it is allocated
+// exactly once.
+template<typename Old, typename String>
+String replace_helper(String copy, const Old& old, std::string_view with, std::ptrdiff_t count)
+{
+    if (count == 0)
+    {
+        return copy;
+    }
+
+    const std::string_view view = copy;
+    const auto find = [&](std::string_view::size_type from) { return search_helper(view, old, from); };
+    if (old.length() > 0 && with.length() <= old.length())
+    {
+        std::string::size_type write = 0;
+        replace_pieces_helper(view, old.length(), with, count, find, [&](std::string_view piece)
+        {
+            std::memmove(&copy[write], piece.data(), piece.length());
+            write += piece.length();
+        });
+        copy.resize(write);
+        return copy;
+    }
+
+    std::string::size_type length = 0;
+    replace_pieces_helper(view, old.length(), with, count, find, [&](std::string_view piece) { length += piece.length(); });
+    if (length == copy.length())
+    {
+        return copy;
+    }
+
+    String out(copy.get_allocator());
+    out.reserve(length);
+    replace_pieces_helper(view, old.length(), with, count, find, [&](std::string_view piece) { out.append(piece); });
+    return out;
+}
+
+inline std::string replace(std::string copy, std::string_view old, std::string_view with, std::ptrdiff_t count = max_count)
+{
+    return replace_helper(std::move(copy), old, with, count);
+}
+
+inline std::string replace(std::string copy, const searcher& old, std::string_view with, std::ptrdiff_t count = max_count)
+{
+    return replace_helper(std::move(copy), old, with, count);
+}
+
+struct replacement_t
+{
+    std::string old, with;
+    std::ptrdiff_t count = max_count;
+};
+
+// Applies many replacements in a single left-to-right pass with an
+// Aho-Corasick automaton. Where matches overlap, the leftmost wins and, of
+// those starting at the same position, the longest. Each pattern is replaced
+// at most count times; a pattern listed twice uses its first entry. After
+// each replacement the scan restarts at its end, rereading up to L bytes
+// for L the longest pattern, so apply() is O(n * L) at worst.
+class replacer
+{
+public:
+    typedef std::string_view::size_type size_type;
+
+    explicit replacer(std::initializer_list<replacement_t> replacements)
+        :byte_class_(), classes_(1), transitions_(), depth_(), terminal_(), dict_link_(), with_(), lengths_(), counts_()
+    {
+        compile(replacements.begin(), replacements.end());
+    }
+
+    explicit replacer(const std::vector<replacement_t>& replacements)
+        :byte_class_(), classes_(1), transitions_(), depth_(), terminal_(), dict_link_(), with_(), lengths_(), counts_()
+    {
+        compile(replacements.data(), replacements.data() + replacements.size());
+    }
+
+    std::string apply(std::string_view s) const
+    {
+        std::string out;
+        out.reserve(s.length());
+
+        std::vector<std::ptrdiff_t> remaining(counts_);
+        int active = std::count_if(remaining.begin(), remaining.end(), [](std::ptrdiff_t count) { return count > 0; });
+        size_type copied = 0, pos = 0, best_start = 0;
+        int state = 0, best = -1;
+        while (active > 0)
+        {
+            const bool at_end = pos == s.length();
+            if (!at_end)
+            {
+                state = transitions_[state * classes_ + byte_class_[static_cast<unsigned char>(s[pos])]];
+                ++pos;
+                for (int match = terminal_[state] >= 0 ? state : dict_link_[state]; match >= 0; match = dict_link_[match])
+                {
+                    const int pattern = terminal_[match];
+                    const size_type start = pos - lengths_[pattern];
+                    if (remaining[pattern] > 0
+                        && (best < 0 || start < best_start || (start == best_start && lengths_[pattern] > lengths_[best])))
+                    {
+                        best = pattern;
+                        best_start = start;
+                    }
+                }
+            }
+
+            // Commit once no partial match starting at or before the best
+            // candidate is still alive.
+            if (best >= 0 && (at_end || pos - depth_[state] > best_start))
+            {
+                out.append(s.data() + copied, best_start - copied);
+                out.append(with_[best]);
+                if (--remaining[best] == 0)
+                {
+                    --active;
+                }
+                copied = pos = best_start + lengths_[best];
+                state = 0;
+                best = -1;
+            }
+            else if (at_end)
+            {
+                break;
+            }
+        }
+        out.append(s.data() + copied, s.length() - copied);
+        return out;
+    }
+
+private:
+    void compile(const replacement_t* first, const replacement_t* last)
+    {
+        for (const replacement_t* current = first; current != last; ++current)
+        {
+            if (current->old.empty())
+            {
+                throw value_error("empty pattern");
+            }
+            for (std::string::const_iterator ch = current->old.begin(), end = current->old.end(); ch != end; ++ch)
+            {
+                byte_class_[static_cast<unsigned char>(*ch)] = 1;
+            }
+        }
+        for (unsigned short& byte_class : byte_class_)
+        {
+            byte_class = byte_class ? classes_++ : 0;
+        }
+
+        add_state(0);
+        for (const replacement_t* current = first; current != last; ++current)
+        {
+            int state = 0;
+            for (std::string::const_iterator ch = current->old.begin(), end = current->old.end(); ch != end; ++ch)
+            {
+                const size_type transition = state * classes_ + byte_class_[static_cast<unsigned char>(*ch)];
+                if (transitions_[transition] < 0)
+                {
+                    transitions_[transition] = add_state(depth_[state] + 1);
+                }
+                state = transitions_[transition];
+            }
+            if (terminal_[state] >= 0)
+            {
+                continue;
+            }
+            terminal_[state] = with_.size();
+            with_.push_back(current->with);
+            lengths_.push_back(current->old.length());
+            counts_.push_back(limit_helper(current->count));
+        }
+
+        // Breadth-first, so each state's failure state is complete before
+        // its own missing transitions are filled in from it.
+        std::vector<int> failure(depth_.size(), 0), queue;
+        for (int byte_class = 0; byte_class < classes_; ++byte_class)
+        {
+            int& next = transitions_[byte_class];
+            if (next < 0)
+            {
+                next = 0;
+            }
+            else
+            {
+                queue.push_back(next);
+            }
+        }
+        for (std::vector<int>::size_type head = 0; head < queue.size(); ++head)
+        {
+            const int state = queue[head];
+            dict_link_[state] = terminal_[failure[state]] >= 0 ? failure[state] : dict_link_[failure[state]];
+            for (int byte_class = 0; byte_class < classes_; ++byte_class)
+            {
+                const int fallback = transitions_[failure[state] * classes_ + byte_class];
+                int& next = transitions_[state * classes_ + byte_class];
+                if (next < 0)
+                {
+                    next = fallback;
+                }
+                else
+                {
+                    failure[next] = fallback;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+
+    int add_state(size_type depth)
+    {
+        transitions_.resize(transitions_.size() + classes_, -1);
+        depth_.push_back(depth);
+        terminal_.push_back(-1);
+        dict_link_.push_back(-1);
+        return depth_.size() - 1;
+    }
+
+    unsigned short byte_class_[std::numeric_limits<unsigned char>::max() + 1];
+    int classes_;
+    std::vector<int> transitions_;
+    std::vector<size_type> depth_;
+    std::vector<int> terminal_, dict_link_;
+    std::vector<std::string> with_;
+    std::vector<size_type> lengths_;
+    std::vector<std::ptrdiff_t> counts_;
+};
+
+inline std::string replace_many(std::string_view s, const replacer& replacements)
+{
+    return replacements.apply(s);
+}
+
+inline std::string replace_many(std::string_view s, std::initializer_list<replacement_t> replacements)
+{
+    return replacer(replacements).apply(s);
+}
+
+template<typename Substring>
+std::ptrdiff_t rfind_helper(std::string_view s, const Substring& substring, std::ptrdiff_t start, std::ptrdiff_t end)
+{
+    std::ptrdiff_t pos = rsearch_helper(s, substring, end);
+    if (start > pos
+        || pos > end - static_cast<std::ptrdiff_t>(substring.length()))
+    {
+        pos = -1;
+    }
+    return pos;
+}
+
+inline std::ptrdiff_t rfind(std::string_view s, std::string_view substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos)
+{
+    return rfind_helper(s, substring, start, end);
+}
+
+inline std::ptrdiff_t rfind(std::string_view s, const searcher& substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos)
+{
+    return rfind_helper(s, substring, start, end);
+}
+
+std::ptrdiff_t rindex(std::string_view s, std::string_view substring, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos);
+
+inline std::string rjust(const std::string& s, int width, char fillchar = ' ')
+{
+    return pad_helper(s, width, fillchar, align_right);
+}
+
+void rjust_inplace(std::string& s, int width, char fillchar = ' ');
+
+inline std::string rjust(std::string&& s, int width, char fillchar = ' ')
+{
+    rjust_inplace(s, width, fillchar);
+    return std::move(s);
+}
+
+inline partition_view_t rpartition_view(std::string_view s, std::string_view sep)
+{
+    return partition_view_helper(s, sep, rsearch_helper(s, sep));
+}
+
+inline partition_view_t rpartition_view(std::string_view s, const searcher& sep)
+{
+    return partition_view_helper(s, sep, rsearch_helper(s, sep));
+}
+
+inline partition_t rpartition(std::string_view s, std::string_view sep)
+{
+    return partition_helper(rpartition_view(s, sep));
+}
+
+inline partition_t rpartition(std::string_view s, const searcher& sep)
+{
+    return partition_helper(rpartition_view(s, sep));
+}
+
+template<typename Tokenizer>
+class token_range
+{
+public:
+    class iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string_view* pointer;
+        typedef const std::string_view& reference;
+
+        iterator()
+            :tokenizer_(), token_(), end_(true)
+        {
+        }
+
+        explicit iterator(const Tokenizer& tokenizer)
+            :tokenizer_(tokenizer), token_(), end_(false)
+        {
+            ++*this;
+        }
+
+        reference operator*() const
+        {
+            return token_;
+        }
+
+        pointer operator->() const
+        {
+            return &token_;
+        }
+
+        iterator& operator++()
+        {
+            end_ = !tokenizer_.next(token_);
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator previous(*this);
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const
+        {
+            return end_ == other.end_
+                && (end_ || (token_.data() == other.token_.data() && token_.size() == other.token_.size()));
+        }
+
+        bool operator!=(const iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        Tokenizer tokenizer_;
+        std::string_view token_;
+        bool end_;
+    };
+
+    typedef iterator const_iterator;
+
+    explicit token_range(const Tokenizer& tokenizer)
+        :tokenizer_(tokenizer)
+    {
+    }
+
+    iterator begin() const
+    {
+        return iterator(tokenizer_);
+    }
+
+    iterator end() const
+    {
+        return iterator();
+    }
+
+private:
+    Tokenizer tokenizer_;
+};
+
+template<typename Separator>
+class basic_separator_tokenizer
+{
+public:
+    basic_separator_tokenizer()
+        :rest_(), sep_(), max_split_(0), done_(true)
+    {
+    }
+
+    basic_separator_tokenizer(std::string_view s, const Separator& sep, std::ptrdiff_t max_split)
+        :rest_(s), sep_(sep), max_split_(limit_helper(max_split)), done_(false)
+    {
+        if (sep.length() == 0)
+        {
+            throw value_error("empty separator");
+        }
+    }
+
+    bool next(std::string_view& token)
+    {
+        if (done_)
+        {
+            return false;
+        }
+
+        const std::string_view::size_type pos = max_split_ > 0 ? search_helper(rest_, sep_) : std::string_view::npos;
+        if (pos == std::string_view::npos)
+        {
+            token = rest_;
+            done_ = true;
+            return true;
+        }
+
+        token = rest_.substr(0, pos);
+        rest_.remove_prefix(pos + sep_.length());
+        --max_split_;
+        return true;
+    }
+
+private:
+    std::string_view rest_;
+    Separator sep_;
+    std::ptrdiff_t max_split_;
+    bool done_;
+};
+
+typedef basic_separator_tokenizer<std::string_view> separator_tokenizer;
+
+class any_separator_tokenizer
+{
+public:
+    any_separator_tokenizer()
+        :rest_(), seps_(), max_split_(0), done_(true)
+    {
+    }
+
+    any_separator_tokenizer(std::string_view s, const charset& seps, std::ptrdiff_t max_split)
+        :rest_(s), seps_(seps), max_split_(limit_helper(max_split)), done_(false)
+    {
+        if (seps.empty())
+        {
+            throw value_error("empty separator");
+        }
+    }
+
+    bool next(std::string_view& token)
+    {
+        if (done_)
+        {
+            return false;
+        }
+
+        std::string_view::size_type pos = 0;
+        while (max_split_ > 0 && pos < rest_.length() && !seps_.contains(rest_[pos]))
+        {
+            ++pos;
+        }
+        if (max_split_ <= 0 || pos == rest_.length())
+        {
+            token = rest_;
+            done_ = true;
+            return true;
+        }
+
+        token = rest_.substr(0, pos);
+        rest_.remove_prefix(pos + 1);
+        --max_split_;
+        return true;
+    }
+
+private:
+    std::string_view rest_;
+    charset seps_;
+    std::ptrdiff_t max_split_;
+    bool done_;
+};
+
+class whitespace_tokenizer
+{
+public:
+    whitespace_tokenizer()
+        :rest_()
+    {
+    }
+
+    explicit whitespace_tokenizer(std::string_view s)
+        :rest_(s)
+    {
+    }
+
+    bool next(std::string_view& token)
+    {
+        std::string_view::const_iterator begin = std::find_if_not(rest_.begin(), rest_.end(), ::isspace);
+        if (begin == rest_.end())
+        {
+            rest_ = std::string_view();
+            return false;
+        }
+
+        std::string_view::const_iterator end = std::find_if(begin, rest_.end(), ::isspace);
+        token = rest_.substr(begin - rest_.begin(), end - begin);
+        rest_.remove_prefix(end - rest_.begin());
+        return true;
+    }
+
+private:
+    std::string_view rest_;
+};
+
+// Equivalent to s.find_first_of("\r\n", pos).
+inline std::string_view::size_type newline_helper(std::string_view s, std::string_view::size_type pos = 0)
+{
+    return find_bytes_helper(s, pos, '\r', '\n', '\n');
+}
+
+// Lines end at "\r\n", "\r" or "\n"; a final line without one is still a
+// line, but a trailing line ending does not start an empty one.
+class line_tokenizer
+{
+public:
+    line_tokenizer()
+        :rest_(), keepends_(false)
+    {
+    }
+
+    line_tokenizer(std::string_view s, bool keepends)
+        :rest_(s), keepends_(keepends)
+    {
+    }
+
+    bool next(std::string_view& token)
+    {
+        if (rest_.empty())
+        {
+            return false;
+        }
+
+        const std::string_view::size_type new_line = newline_helper(rest_);
+        if (new_line == std::string_view::npos)
+        {
+            token = rest_;
+            rest_.remove_prefix(rest_.length());
+            return true;
+        }
+
+        std::string_view::size_type newline_size = 1;
+        if ('\r' == rest_[new_line] && new_line + 1 < rest_.length() && '\n' == rest_[new_line + 1])
+        {
+            newline_size = 2;
+        }
+        token = rest_.substr(0, new_line + (keepends_ ? newline_size : 0));
+        rest_.remove_prefix(new_line + newline_size);
+        return true;
+    }
+
+private:
+    std::string_view rest_;
+    bool keepends_;
+};
+
+inline token_range<separator_tokenizer> split_range(std::string_view s, std::string_view sep, std::ptrdiff_t max_split = max_count)
+{
+    return token_range<separator_tokenizer>(separator_tokenizer(s, sep, max_split));
+}
+
+inline token_range<basic_separator_tokenizer<searcher> > split_range(std::string_view s, const searcher& sep, std::ptrdiff_t max_split = max_count)
+{
+    return token_range<basic_separator_tokenizer<searcher> >(basic_separator_tokenizer<searcher>(s, sep, max_split));
+}
+
+// Splits at every byte in seps; like split(), adjacent separators give empty
+// tokens.
+inline token_range<any_separator_tokenizer> split_any_range(std::string_view s, const charset& seps, std::ptrdiff_t max_split = max_count)
+{
+    return token_range<any_separator_tokenizer>(any_separator_tokenizer(s, seps, max_split));
+}
+
+inline token_range<whitespace_tokenizer> whitespace_split_range(std::string_view s)
+{
+    return token_range<whitespace_tokenizer>(whitespace_tokenizer(s));
+}
+
+inline token_range<line_tokenizer> lines_range(std::string_view s, bool keepends = false)
+{
+    return token_range<line_tokenizer>(line_tokenizer(s, keepends));
+}
+
+// Written through output iterators so that both std::string and
+// std::string_view containers can collect tokens.
+class split_token_helper
+{
+public:
+    explicit split_token_helper(std::string_view token)
+        : token_(token)
+    {
+    }
+
+    operator std::string_view() const
+    {
+        return token_;
+    }
+
+    operator std::string() const
+    {
+        return std::string(token_);
+    }
+
+private:
+    std::string_view token_;
+};
+
+template<typename T>
+struct is_split_sink_helper
+    : std::integral_constant<bool, !std::is_arithmetic<T>::value
+                                   && !std::is_convertible<T, std::string_view>::value
+                                   && !std::is_convertible<T, const searcher&>::value>
+{
+};
+
+template<typename Range, typename OutputIterator>
+OutputIterator copy_tokens_helper(const Range& range, OutputIterator out)
+{
+    for (typename Range::const_iterator current = range.begin(), end = range.end(); current != end; ++current)
+    {
+        *out++ = split_token_helper(*current);
+    }
+    return out;
+}
+
+// A callback may return bool; false stops the iteration early. Returns
+// whether every token was visited.
+template<typename Range, typename Callback>
+bool each_token_helper(const Range& range, Callback&& f)
+{
+    for (typename Range::const_iterator current = range.begin(), end = range.end(); current != end; ++current)
+    {
+        if constexpr (std::is_same<decltype(f(*current)), bool>::value)
+        {
+            if (!f(*current))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            f(*current);
+        }
+    }
+    return true;
+}
+
+inline string_view_list split_helper_view(std::string_view s)
+{
+    const token_range<whitespace_tokenizer> range = whitespace_split_range(s);
+    return string_view_list(range.begin(), range.end());
+}
+
+template<typename OutputIterator>
+OutputIterator split_helper(std::string_view s, OutputIterator out)
+{
+    return copy_tokens_helper(whitespace_split_range(s), out);
+}
+
+string_list split_helper(std::string_view s);
+
+inline string_view_list rsplit_view(std::string_view s)
+{
+    return split_helper_view(s);
+}
+
+template<typename Separator>
+string_view_list rsplit_view_helper(std::string_view s, const Separator& sep, std::ptrdiff_t max_split)
+{
+    if (sep.length() == 0)
+    {
+        throw value_error("empty separator");
+    }
+
+    max_split = limit_helper(max_split);
+    string_view_list split;
+    const std::string_view::size_type sep_length = sep.length();
+    std::string_view::size_type last_pos = s.length();
+    for (std::string_view::size_type pos = rsearch_helper(s, sep);
+         pos != std::string_view::npos && max_split > 0;
+         pos = last_pos < sep_length ? std::string_view::npos : rsearch_helper(s, sep, last_pos - sep_length))
+    {
+        split.push_back(s.substr(pos + sep_length, last_pos - pos - sep_length));
+        last_pos = pos;
+        --max_split;
+    }
+    split.push_back(s.substr(0, last_pos));
+    std::reverse(split.begin(), split.end());
+    return split;
+}
+
+inline string_view_list rsplit_view(std::string_view s, std::string_view sep, std::ptrdiff_t max_split = max_count)
+{
+    return rsplit_view_helper(s, sep, max_split);
+}
+
+inline string_view_list rsplit_view(std::string_view s, const searcher& sep, std::ptrdiff_t max_split = max_count)
+{
+    return rsplit_view_helper(s, sep, max_split);
+}
+
+template<typename OutputIterator, typename = std::enable_if_t<is_split_sink_helper<OutputIterator>::value> >
+OutputIterator rsplit(std::string_view s, OutputIterator out)
+{
+    return split_helper(s, out);
+}
+
+template<typename OutputIterator, typename = std::enable_if_t<is_split_sink_helper<OutputIterator>::value> >
+OutputIterator rsplit(std::string_view s, std::string_view sep, OutputIterator out, std::ptrdiff_t max_split = max_count)
+{
+    return copy_tokens_helper(rsplit_view_helper(s, sep, max_split), out);
+}
+
+template<typename OutputIterator, typename = std::enable_if_t<is_split_sink_helper<OutputIterator>::value> >
+OutputIterator rsplit(std::string_view s, const searcher& sep, OutputIterator out, std::ptrdiff_t max_split = max_count)
+{
+    return copy_tokens_helper(rsplit_view_helper(s, sep, max_split), out);
+}
+
+inline string_list rsplit(std::string_view s)
+{
+    return split_helper(s);
+}
+
+string_list rsplit(std::string_view s, std::string_view sep, std::ptrdiff_t max_split = max_count);
+
+string_list rsplit(std::string_view s, const searcher& sep, std::ptrdiff_t max_split = max_count);
+
+template<typename Callback>
+bool rsplit_each(std::string_view s, Callback&& f)
+{
+    return each_token_helper(whitespace_split_range(s), f);
+}
+
+template<typename Callback>
+bool rsplit_each(std::string_view s, std::string_view sep, Callback&& f, std::ptrdiff_t max_split = max_count)
+{
+    return each_token_helper(rsplit_view_helper(s, sep, max_split), f);
+}
+
+template<typename Callback>
+bool rsplit_each(std::string_view s, const searcher& sep, Callback&& f, std::ptrdiff_t max_split = max_count)
+{
+    return each_token_helper(rsplit_view_helper(s, sep, max_split), f);
+}
+
+inline string_view_list split_view(std::string_view s)
+{
+    return split_helper_view(s);
+}
+
+inline string_view_list split_view(std::string_view s, std::string_view sep, std::ptrdiff_t max_split = max_count)
+{
+    const token_range<separator_tokenizer> range = split_range(s, sep, max_split);
+    return string_view_list(range.begin(), range.end());
+}
+
+inline string_view_list split_view(std::string_view s, const searcher& sep, std::ptrdiff_t max_split = max_count)
+{
+    const token_range<basic_separator_tokenizer<searcher> > range = split_range(s, sep, max_split);
+    return string_view_list(range.begin(), range.end());
+}
+
+template<typename OutputIterator, typename = std::enable_if_t<is_split_sink_helper<OutputIterator>::value> >
+OutputIterator split(std::string_view s, OutputIterator out)
+{
+    return split_helper(s, out);
+}
+
+template<typename OutputIterator, typename = std::enable_if_t<is_split_sink_helper<OutputIterator>::value> >
+OutputIterator split(std::string_view s, std::string_view sep, OutputIterator out, std::ptrdiff_t max_split = max_count)
+{
+    return copy_tokens_helper(split_range(s, sep, max_split), out);
+}
+
+template<typename OutputIterator, typename = std::enable_if_t<is_split_sink_helper<OutputIterator>::value> >
+OutputIterator split(std::string_view s, const searcher& sep, OutputIterator out, std::ptrdiff_t max_split = max_count)
+{
+    return copy_tokens_helper(split_range(s, sep, max_split), out);
+}
+
+inline string_list split(std::string_view s)
+{
+    return split_helper(s);
+}
+
+string_list split(std::string_view s, std::string_view sep, std::ptrdiff_t max_split = max_count);
+
+string_list split(std::string_view s, const searcher& sep, std::ptrdiff_t max_split = max_count);
+
+inline string_view_list split_any_view(std::string_view s, const charset& seps, std::ptrdiff_t max_split = max_count)
+{
+    const token_range<any_separator_tokenizer> range = split_any_range(s, seps, max_split);
+    return string_view_list(range.begin(), range.end());
+}
+
+inline string_list split_any(std::string_view s, const charset& seps, std::ptrdiff_t max_split = max_count)
+{
+    const token_range<any_separator_tokenizer> range = split_any_range(s, seps, max_split);
+    return string_list(range.begin(), range.end());
+}
+
+template<typename Callback>
+bool split_each(std::string_view s, Callback&& f)
+{
+    return each_token_helper(whitespace_split_range(s), f);
+}
+
+template<typename Callback>
+bool split_each(std::string_view s, std::string_view sep, Callback&& f, std::ptrdiff_t max_split = max_count)
+{
+    return each_token_helper(split_range(s, sep, max_split), f);
+}
+
+template<typename Callback>
+bool split_each(std::string_view s, const searcher& sep, Callback&& f, std::ptrdiff_t max_split = max_count)
+{
+    return each_token_helper(split_range(s, sep, max_split), f);
+}
+
+inline bool isnewline(char ch)
+{
+    return '\r' == ch || '\n' == ch;
+}
+
+inline string_view_list splitlines_view(std::string_view s, bool keepends = false)
+{
+    const token_range<line_tokenizer> range = lines_range(s, keepends);
+    return string_view_list(range.begin(), range.end());
+}
+
+template<typename OutputIterator, typename = std::enable_if_t<is_split_sink_helper<OutputIterator>::value> >
+OutputIterator splitlines(std::string_view s, OutputIterator out, bool keepends = false)
+{
+    return copy_tokens_helper(lines_range(s, keepends), out);
+}
+
+string_list splitlines(std::string_view s, bool keepends = false);
+
+template<typename Callback>
+bool splitlines_each(std::string_view s, Callback&& f, bool keepends = false)
+{
+    return each_token_helper(lines_range(s, keepends), f);
+}
+
+// Reads lines from a stream or file descriptor a chunk at a time, with the
+// same line endings and keepends handling as splitlines(). A line is a view
+// into an internal buffer and stays valid until the next call to next().
+// The buffer only grows to hold the longest line plus one chunk.
+class line_reader
+{
+public:
+    explicit line_reader(std::istream& in, bool keepends = false, std::size_t chunk_size = 64 * 1024)
+        :in_(&in), fd_(-1), keepends_(keepends), chunk_size_(chunk_size), buffer_(), begin_(0), scanned_(0), end_(0), eof_(false)
+    {
+    }
+
+    explicit line_reader(int fd, bool keepends = false, std::size_t chunk_size = 64 * 1024)
+        :in_(0), fd_(fd), keepends_(keepends), chunk_size_(chunk_size), buffer_(), begin_(0), scanned_(0), end_(0), eof_(false)
+    {
+    }
+
+    line_reader(const line_reader&) = delete;
+    line_reader& operator=(const line_reader&) = delete;
+
+    bool next(std::string_view& line);
+
+private:
+    void fill();
+    std::size_t read(char* out, std::size_t count);
+
+    std::istream* in_;
+    int fd_;
+    bool keepends_;
+    std::size_t chunk_size_;
+    std::vector<char> buffer_;
+    std::size_t begin_, scanned_, end_;
+    bool eof_;
+};
+
+// A whole file as a string_view, mapped read-only rather than copied.
+// Empty files need no mapping, and anything that cannot be mapped, such as
+// a pipe or a /proc file, is read into memory instead.
+class mapped_text
+{
+public:
+    explicit mapped_text(const std::string& path);
+
+    mapped_text(const mapped_text&) = delete;
+    mapped_text& operator=(const mapped_text&) = delete;
+
+    ~mapped_text();
+
+    bool mapped() const
+    {
+        return mapped_;
+    }
+
+    std::string_view view() const
+    {
+        return std::string_view(data_, size_);
+    }
+
+    operator std::string_view() const
+    {
+        return view();
+    }
+
+private:
+    void read_all(int fd);
+
+    const char* data_;
+    std::size_t size_;
+    bool mapped_;
+    std::string contents_;
+};
+
+inline bool startswith(std::string_view s, std::string_view prefix, std::ptrdiff_t start = 0, std::ptrdiff_t end = max_pos)
+{
+    end = std::min<std::ptrdiff_t>(end, s.size());
+    return start <= end
+        && (end - start >= static_cast<std::ptrdiff_t>(prefix.length()))
+        && std::equal(prefix.begin(), prefix.end(), s.begin() + start);
+}
+
+inline char swapcase_helper(char ch)
+{
+    if (::islower(static_cast<unsigned char>(ch)))
+    {
+        ch = upper_helper(ch);
+    }
+    else if (::isupper(static_cast<unsigned char>(ch)))
+    {
+        ch = lower_helper(ch);
+    }
+    return ch;
+}
+
+std::string swapcase(const std::string& s);
+
+inline void swapcase_inplace(std::string& s)
+{
+    case_helper(s, &s[0], true, true, swapcase_helper);
+}
+
+inline std::string swapcase(std::string&& s)
+{
+    swapcase_inplace(s);
+    return std::move(s);
+}
+
+struct titlecase_helper
+{
+    titlecase_helper()
+        :uppercase_next_(true)
+    {
+    }
+
+    char operator()(const char& ch)
+    {
+        char out = ch;
+        if (::isalpha(ch))
+        {
+            if (uppercase_next_)
+            {
+                out = ::toupper(ch);
+                uppercase_next_ = false;
+            }
+            else
+            {
+                out = ::tolower(ch);
+            }
+        }
+        else
+        {
+            uppercase_next_ = true;
+        }
+        return out;
+    }
+
+    bool uppercase_next_;
+};
+
+std::string title(const std::string& s);
+
+inline void title_inplace(std::string& s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), titlecase_helper());
+}
+
+inline std::string title(std::string&& s)
+{
+    title_inplace(s);
+    return std::move(s);
+}
+
+// A compiled translate() table: a byte map plus a bitmap of bytes to
+// delete. Deleted bytes are still written but the output position only
+// advances for kept ones, so the loop has no data-dependent branches.
+class translation
+{
+public:
+    translation()
+        :map_(), delete_(), deletes_(false)
+    {
+        for (int ch = 0; ch < 256; ++ch)
+        {
+            map_[ch] = static_cast<char>(ch);
+        }
+    }
+
+    explicit translation(std::string_view table, std::string_view delete_chars = "")
+        :map_(), delete_(), deletes_(false)
+    {
+        if (table.length() != 256)
+        {
+            throw value_error("translation table must be 256 characters long");
+        }
+        std::copy(table.begin(), table.end(), map_);
+        add_deletes(delete_chars);
+    }
+
+    translation(std::string_view from, std::string_view to, std::string_view delete_chars)
+        :translation()
+    {
+        if (from.length() != to.length())
+        {
+            throw value_error("the first two maketrans arguments must have equal length");
+        }
+        for (std::string_view::size_type i = 0; i < from.length(); ++i)
+        {
+            map_[static_cast<unsigned char>(from[i])] = to[i];
+        }
+        add_deletes(delete_chars);
+    }
+
+    char map(char ch) const
+    {
+        return map_[static_cast<unsigned char>(ch)];
+    }
+
+    bool deletes(char ch) const
+    {
+        const unsigned char byte = ch;
+        return (delete_[byte >> 6] >> (byte & 63)) & 1;
+    }
+
+    void apply_inplace(std::string& s) const
+    {
+        char* const first = &s[0];
+        s.resize(apply(first, first + s.length(), first) - first);
+    }
+
+    std::string apply(std::string_view s) const
+    {
+        std::string copy(s);
+        apply_inplace(copy);
+        return copy;
+    }
+
+    // Writes the translation of [first, last) to out, which may be first,
+    // and returns the end of the output.
+    char* apply(const char* first, const char* last, char* out) const
+    {
+        if (!deletes_)
+        {
+            for (; first != last; ++first)
+            {
+                *out++ = map(*first);
+            }
+            return out;
+        }
+
+        for (; first != last; ++first)
+        {
+            const char ch = *first;
+            *out = map(ch);
+            out += !deletes(ch);
+        }
+        return out;
+    }
+
+private:
+    void add_deletes(std::string_view delete_chars)
+    {
+        for (std::string_view::const_iterator current = delete_chars.begin(), end = delete_chars.end(); current != end; ++current)
+        {
+            const unsigned char byte = *current;
+            delete_[byte >> 6] |= std::uint64_t(1) << (byte & 63);
+            deletes_ = true;
+        }
+    }
+
+    char map_[std::numeric_limits<unsigned char>::max() + 1];
+    std::uint64_t delete_[4];
+    bool deletes_;
+};
+
+inline translation maketrans(std::string_view from, std::string_view to, std::string_view delete_chars = "")
+{
+    return translation(from, to, delete_chars);
+}
+
+inline void translate_inplace(std::string& s, const translation& table)
+{
+    table.apply_inplace(s);
+}
+
+inline std::string translate(const std::string& s, const translation& table)
+{
+    return table.apply(s);
+}
+
+inline std::string translate(std::string&& s, const translation& table)
+{
+    table.apply_inplace(s);
+    return std::move(s);
+}
+
+inline void translate_inplace(std::string& s, const std::string& translation_table, const std::string& delete_chars = "")
+{
+    translation(translation_table, delete_chars).apply_inplace(s);
+}
+
+std::string translate(const std::string& s, const std::string& translation_table, const std::string& delete_chars = "");
+
+inline std::string translate(std::string&& s, const std::string& translation_table, const std::string& delete_chars = "")
+{
+    translate_inplace(s, translation_table, delete_chars);
+    return std::move(s);
+}
+
+std::string upper(const std::string& s);
+
+inline void upper_inplace(std::string& s)
+{
+    case_helper(s, &s[0], true, false, upper_helper);
+}
+
+inline std::string upper(std::string&& s)
+{
+    upper_inplace(s);
+    return std::move(s);
+}
+
+inline std::string zfill(const std::string& s, int width)
+{
+    return rjust(s, width, '0');
+}
+
+struct column_t
+{
+    int width = 0;
+    alignment_t alignment = align_left;
+    char fill = ' ';
+    // Pads as zfill() does, overriding alignment and fill.
+    bool zero_pad = false;
+    // Lets fit() widen the column to its widest cell.
+    bool auto_width = false;
+};
+
+// Lays out rows of cells in fixed-width columns, appending each row, with
+// the cells padded as by ljust, rjust, center or zfill, to one buffer.
+class table_formatter
+{
+public:
+    explicit table_formatter(const std::vector<column_t>& columns, std::string_view separator = " ")
+        :columns_(columns), separator_(separator), out_()
+    {
+    }
+
+    // A first pass over the data for auto_width columns.
+    template<typename Rows>
+    void fit(const Rows& rows)
+    {
+        for (typename Rows::const_iterator row = rows.begin(), end = rows.end(); row != end; ++row)
+        {
+            fit_row(*row);
+        }
+    }
+
+    template<typename Row>
+    void fit_row(const Row& row)
+    {
+        std::vector<column_t>::iterator column = columns_.begin();
+        for (typename Row::const_iterator cell = row.begin(), end = row.end(); cell != end && column != columns_.end(); ++cell, ++column)
+        {
+            if (column->auto_width)
+            {
+                column->width = std::max<std::ptrdiff_t>(column->width, join_item_helper(*cell).length());
+            }
+        }
+    }
+
+    template<typename Rows>
+    void add_rows(const Rows& rows)
+    {
+        for (typename Rows::const_iterator row = rows.begin(), end = rows.end(); row != end; ++row)
+        {
+            add_row(*row);
+        }
+    }
+
+    // Missing trailing cells are written as empty ones. A row with too
+    // many cells is rejected before any of it is written.
+    template<typename Row>
+    void add_row(const Row& row)
+    {
+        if (static_cast<std::size_t>(std::distance(row.begin(), row.end())) > columns_.size())
+        {
+            throw value_error("row has more cells than columns");
+        }
+        std::vector<column_t>::const_iterator column = columns_.begin();
+        for (typename Row::const_iterator cell = row.begin(), end = row.end(); cell != end; ++cell, ++column)
+        {
+            add_cell(*column, join_item_helper(*cell));
+        }
+        for (; column != columns_.end(); ++column)
+        {
+            add_cell(*column, std::string_view());
+        }
+        out_.push_back('\n');
+    }
+
+    void add_row(std::initializer_list<std::string_view> row)
+    {
+        add_row<std::initializer_list<std::string_view> >(row);
+    }
+
+    const std::vector<column_t>& columns() const
+    {
+        return columns_;
+    }
+
+    const std::string& str() const
+    {
+        return out_;
+    }
+
+    void clear()
+    {
+        out_.clear();
+    }
+
+private:
+    void add_cell(const column_t& column, std::string_view cell)
+    {
+        if (&column != &columns_.front())
+        {
+            out_.append(separator_);
+        }
+        if (column.zero_pad)
+        {
+            pad_helper(out_, cell, column.width, '0', align_right);
+        }
+        else
+        {
+            pad_helper(out_, cell, column.width, column.fill, column.alignment);
+        }
+    }
+
+    std::vector<column_t> columns_;
+    std::string separator_;
+    std::string out_;
+};
+
+
+// A string of at most N characters held inline, so that it can be built
+// and transformed in constant expressions and stored in read-only data.
+template<std::size_t N>
+class fixed_string
+{
+public:
+    constexpr fixed_string()
+        :chars_(), size_(0)
+    {
+    }
+
+    constexpr fixed_string(const char (&s)[N + 1])
+        :chars_(), size_(0)
+    {
+        append(std::string_view(s, N));
+    }
+
+    constexpr explicit fixed_string(std::string_view s)
+        :chars_(), size_(0)
+    {
+        append(s);
+    }
+
+    constexpr std::size_t size() const
+    {
+        return size_;
+    }
+
+    static constexpr std::size_t capacity()
+    {
+        return N;
+    }
+
+    constexpr const char* data() const
+    {
+        return chars_;
+    }
+
+    constexpr const char* c_str() const
+    {
+        return chars_;
+    }
+
+    constexpr std::string_view view() const
+    {
+        return std::string_view(chars_, size_);
+    }
+
+    constexpr operator std::string_view() const
+    {
+        return view();
+    }
+
+    constexpr char operator[](std::size_t i) const
+    {
+        return chars_[i];
+    }
+
+    constexpr void push_back(char ch)
+    {
+        if (size_ == N)
+        {
+            throw value_error("fixed_string capacity exceeded");
+        }
+        chars_[size_++] = ch;
+    }
+
+    constexpr void append(std::string_view s)
+    {
+        for (std::string_view::size_type i = 0; i < s.length(); ++i)
+        {
+            push_back(s[i]);
+        }
+    }
+
+    constexpr void append(std::size_t count, char ch)
+    {
+        for (; count > 0; --count)
+        {
+            push_back(ch);
+        }
+    }
+
+private:
+    char chars_[N + 1];
+    std::size_t size_;
+};
+
+template<std::size_t N>
+fixed_string(const char (&)[N]) -> fixed_string<N - 1>;
+
+template<std::size_t N>
+constexpr fixed_string<N - 1> fixed(const char (&s)[N])
+{
+    return fixed_string<N - 1>(s);
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+template<std::size_t N>
+struct fixed_literal_helper
+{
+    constexpr fixed_literal_helper(const char (&s)[N])
+        :chars()
+    {
+        std::copy(s, s + N, chars);
+    }
+
+    char chars[N];
+};
+
+inline namespace literals {
+
+template<fixed_literal_helper S>
+constexpr auto operator""_fs()
+{
+    return fixed_string<sizeof S.chars - 1>(S.chars);
+}
+
+}
+#endif
+
+constexpr char ascii_lower_helper(char ch)
+{
+    return 'A' <= ch && ch <= 'Z' ? ch - 'A' + 'a' : ch;
+}
+
+constexpr char ascii_upper_helper(char ch)
+{
+    return 'a' <= ch && ch <= 'z' ? ch - 'a' + 'A' : ch;
+}
+
+// Only ASCII letters change case, as on the SIMD path of the runtime
+// versions.
+template<std::size_t N>
+constexpr fixed_string<N> lower(const fixed_string<N>& s)
+{
+    fixed_string<N> lowercased;
+    for (std::size_t i = 0; i < s.size(); ++i)
+    {
+        lowercased.push_back(ascii_lower_helper(s[i]));
+    }
+    return lowercased;
+}
+
+template<std::size_t N>
+constexpr fixed_string<N> upper(const fixed_string<N>& s)
+{
+    fixed_string<N> uppercased;
+    for (std::size_t i = 0; i < s.size(); ++i)
+    {
+        uppercased.push_back(ascii_upper_helper(s[i]));
+    }
     return uppercased;
 }
 
-std::string zfill(const std::string& s, int width)
+template<std::size_t N>
+constexpr fixed_string<N> lstrip(const fixed_string<N>& s, const charset& chars = strip_chars)
+{
+    return fixed_string<N>(lstrip_view(s, chars));
+}
+
+template<std::size_t N>
+constexpr fixed_string<N> rstrip(const fixed_string<N>& s, const charset& chars = strip_chars)
+{
+    return fixed_string<N>(rstrip_view(s, chars));
+}
+
+template<std::size_t N>
+constexpr fixed_string<N> strip(const fixed_string<N>& s, const charset& chars = strip_chars)
+{
+    return fixed_string<N>(strip_view(s, chars));
+}
+
+template<int Width, std::size_t N>
+constexpr fixed_string<(Width > static_cast<int>(N) ? Width : N)> pad_helper(const fixed_string<N>& s, char fill, alignment_t alignment)
+{
+    fixed_string<(Width > static_cast<int>(N) ? Width : N)> padded;
+    const std::ptrdiff_t padding = Width - static_cast<std::ptrdiff_t>(s.size());
+    const std::ptrdiff_t before = padding > 0 ? pad_before_helper(padding, alignment) : 0;
+    padded.append(before, fill);
+    padded.append(s);
+    padded.append(padding > before ? padding - before : 0, fill);
+    return padded;
+}
+
+template<int Width, std::size_t N>
+constexpr auto ljust(const fixed_string<N>& s, char fill = ' ')
+{
+    return pad_helper<Width>(s, fill, align_left);
+}
+
+template<int Width, std::size_t N>
+constexpr auto rjust(const fixed_string<N>& s, char fill = ' ')
+{
+    return pad_helper<Width>(s, fill, align_right);
+}
+
+template<int Width, std::size_t N>
+constexpr auto center(const fixed_string<N>& s, char fill = ' ')
+{
+    return pad_helper<Width>(s, fill, align_center);
+}
+
+template<int Width, std::size_t N>
+constexpr auto zfill(const fixed_string<N>& s)
+{
+    return pad_helper<Width>(s, '0', align_right);
+}
+
+// Enough room for the most matches any old string can have: one between
+// every character, as when old is empty or strips to empty.
+constexpr std::size_t replace_capacity_helper(std::size_t n, std::size_t k)
+{
+    return n + (n + 1) * k;
+}
+
+// Same results as replace(), searching with std::string_view::find.
+template<std::size_t N, std::size_t M, std::size_t K>
+constexpr fixed_string<replace_capacity_helper(N, K)> replace(const fixed_string<N>& s, const fixed_string<M>& old, const fixed_string<K>& with, std::ptrdiff_t count = max_count)
+{
+    fixed_string<replace_capacity_helper(N, K)> replaced;
+    const std::string_view view = s, old_view = old;
+    replace_pieces_helper(view, old_view.length(), with, count,
+                          [&](std::string_view::size_type from) { return view.find(old_view, from); },
+                          [&](std::string_view piece) { replaced.append(piece); });
+    return replaced;
+}
+
+// A fixed set of worker threads for the parallel overloads below. The
+// calling thread takes part in every run(), so a pool of n threads starts
+// n - 1 workers. Inputs are only divided into chunks of at least grain
+// bytes.
+class thread_pool
+{
+public:
+    explicit thread_pool(unsigned threads = std::thread::hardware_concurrency(), std::size_t grain = 1 << 20);
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool();
+
+    unsigned size() const
+    {
+        return workers_.size() + 1;
+    }
+
+    std::size_t grain() const
+    {
+        return grain_;
+    }
+
+    // Calls f(i) for each i in [0, count) and returns once every call has
+    // finished, rethrowing the first exception thrown by any of them.
+    template<typename F>
+    void run(std::size_t count, F f)
+    {
+        std::atomic<std::size_t> next(0);
+        std::exception_ptr error;
+        const auto loop = [&]
+        {
+            for (std::size_t i = next++; i < count; i = next++)
+            {
+                try
+                {
+                    f(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        const std::size_t helpers = std::min<std::size_t>(workers_.size(), count > 0 ? count - 1 : 0);
+        std::size_t finished = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::size_t i = 0; i < helpers; ++i)
+            {
+                tasks_.push_back([&]
+                {
+                    loop();
+                    std::lock_guard<std::mutex> finished_lock(mutex_);
+                    ++finished;
+                    wake_.notify_all();
+                });
+            }
+        }
+        wake_.notify_all();
+        loop();
+
+        // Run queued tasks while waiting. When run() is called from inside
+        // one of this pool's tasks, every thread may be waiting like this,
+        // and the helpers would otherwise never start.
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (finished != helpers)
+        {
+            if (tasks_.empty())
+            {
+                wake_.wait(lock);
+                continue;
+            }
+            const std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void work();
+
+    std::size_t grain_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()> > tasks_;
+    std::vector<std::thread> workers_;
+    bool stopping_;
+};
+
+// Chunk i of n covers [bounds[i], bounds[i + 1]).
+std::vector<std::size_t> chunk_bounds_helper(const thread_pool& pool, std::size_t length);
+
+// A chunk's non-overlapping matches: those that start in [from, to), found
+// left to right from from. Searches read up to length - 1 bytes past to, so
+// matches straddling a boundary belong to the chunk they start in.
+struct match_run_t
+{
+    std::size_t from, count, first, end;
+};
+
+template<typename Substring>
+match_run_t match_run_helper(std::string_view s, const Substring& substring, std::size_t from, std::size_t to)
+{
+    const std::string_view window = s.substr(0, std::min(s.length(), to + substring.length() - 1));
+    match_run_t run = { from, 0, std::string_view::npos, from };
+    for (std::size_t pos = search_helper(window, substring, from);
+         pos < to;
+         pos = search_helper(window, substring, pos + substring.length()))
+    {
+        if (run.count++ == 0)
+        {
+            run.first = pos;
+        }
+        run.end = pos + substring.length();
+    }
+    return run;
+}
+
+// Each chunk is matched from its own start in parallel. A chunk is then
+// matched again, serially, only when the previous chunk's last match runs
+// past the chunk's first match, which needs a self-overlapping substring.
+// That keeps count() and replace() exactly as they are serially.
+template<typename Substring>
+std::vector<match_run_t> match_runs_helper(thread_pool& pool, std::string_view s, const Substring& substring, const std::vector<std::size_t>& bounds)
+{
+    std::vector<match_run_t> runs(bounds.size() - 1);
+    pool.run(runs.size(), [&](std::size_t i)
+    {
+        runs[i] = match_run_helper(s, substring, bounds[i], bounds[i + 1]);
+    });
+
+    std::size_t carry = 0;
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        const std::size_t from = std::max(bounds[i], carry);
+        if (runs[i].count > 0 && from > runs[i].first)
+        {
+            runs[i] = match_run_helper(s, substring, from, bounds[i + 1]);
+        }
+        runs[i].from = from;
+        if (runs[i].count > 0)
+        {
+            carry = runs[i].end;
+        }
+    }
+    return runs;
+}
+
+template<typename Substring>
+std::ptrdiff_t count_helper(thread_pool& pool, std::string_view s, const Substring& substring)
+{
+    if (substring.length() == 0)
+    {
+        return count(s, substring);
+    }
+
+    const std::vector<match_run_t> runs = match_runs_helper(pool, s, substring, chunk_bounds_helper(pool, s.length()));
+    std::ptrdiff_t count = 0;
+    for (const match_run_t& run : runs)
+    {
+        count += run.count;
+    }
+    return count;
+}
+
+inline std::ptrdiff_t count(thread_pool& pool, std::string_view s, std::string_view substring)
+{
+    return count_helper(pool, s, substring);
+}
+
+inline std::ptrdiff_t count(thread_pool& pool, std::string_view s, const searcher& substring)
+{
+    return count_helper(pool, s, substring);
+}
+
+template<typename Substring>
+std::ptrdiff_t find_helper(thread_pool& pool, std::string_view s, const Substring& substring)
+{
+    if (substring.length() == 0 || substring.length() > s.length())
+    {
+        return find(s, substring);
+    }
+
+    const std::vector<std::size_t> bounds = chunk_bounds_helper(pool, s.length());
+    std::atomic<std::size_t> found(std::string_view::npos);
+    pool.run(bounds.size() - 1, [&](std::size_t i)
+    {
+        if (bounds[i] > found.load())
+        {
+            return;
+        }
+        const std::string_view window = s.substr(0, std::min(s.length(), bounds[i + 1] + substring.length() - 1));
+        const std::size_t pos = search_helper(window, substring, bounds[i]);
+        for (std::size_t current = found.load(); pos < current && !found.compare_exchange_weak(current, pos);)
+        {
+        }
+    });
+    return found.load() == std::string_view::npos ? -1 : static_cast<std::ptrdiff_t>(found.load());
+}
+
+inline std::ptrdiff_t find(thread_pool& pool, std::string_view s, std::string_view substring)
+{
+    return find_helper(pool, s, substring);
+}
+
+inline std::ptrdiff_t find(thread_pool& pool, std::string_view s, const searcher& substring)
+{
+    return find_helper(pool, s, substring);
+}
+
+template<typename Substring>
+std::ptrdiff_t rfind_helper(thread_pool& pool, std::string_view s, const Substring& substring)
+{
+    if (substring.length() == 0 || substring.length() > s.length())
+    {
+        return rfind(s, substring);
+    }
+
+    const std::vector<std::size_t> bounds = chunk_bounds_helper(pool, s.length());
+    std::atomic<std::ptrdiff_t> found(-1);
+    pool.run(bounds.size() - 1, [&](std::size_t i)
+    {
+        if (static_cast<std::ptrdiff_t>(bounds[i + 1]) <= found.load())
+        {
+            return;
+        }
+        const std::string_view window = s.substr(bounds[i], bounds[i + 1] - bounds[i] + substring.length() - 1);
+        const std::size_t pos = rsearch_helper(window, substring, bounds[i + 1] - bounds[i] - 1);
+        if (pos == std::string_view::npos)
+        {
+            return;
+        }
+        const std::ptrdiff_t absolute = bounds[i] + pos;
+        for (std::ptrdiff_t current = found.load(); absolute > current && !found.compare_exchange_weak(current, absolute);)
+        {
+        }
+    });
+    return found.load();
+}
+
+inline std::ptrdiff_t rfind(thread_pool& pool, std::string_view s, std::string_view substring)
+{
+    return rfind_helper(pool, s, substring);
+}
+
+inline std::ptrdiff_t rfind(thread_pool& pool, std::string_view s, const searcher& substring)
+{
+    return rfind_helper(pool, s, substring);
+}
+
+// Matches are found per chunk as for count(); the count limit is then
+// shared out in order and each chunk writes its own slice of the result.
+template<typename Old>
+std::string replace_helper(thread_pool& pool, std::string_view s, const Old& old, std::string_view with, std::ptrdiff_t count)
+{
+    if (count == 0 || old.length() == 0)
+    {
+        return replace_helper(std::string(s), old, with, count);
+    }
+
+    const std::vector<std::size_t> bounds = chunk_bounds_helper(pool, s.length());
+    const std::vector<match_run_t> runs = match_runs_helper(pool, s, old, bounds);
+    std::vector<std::size_t> replacements(runs.size()), out_pos(runs.size() + 1);
+    std::size_t remaining = limit_helper(count), total = 0;
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        replacements[i] = std::min(runs[i].count, remaining);
+        remaining -= replacements[i];
+        out_pos[i] = runs[i].from - total * old.length() + total * with.length();
+        total += replacements[i];
+    }
+    if (total == 0)
+    {
+        return std::string(s);
+    }
+    out_pos[runs.size()] = s.length() - total * old.length() + total * with.length();
+
+    std::string out(out_pos[runs.size()], '\0');
+    char* const data = &out[0];
+    pool.run(runs.size(), [&](std::size_t i)
+    {
+        const std::size_t end = i + 1 < runs.size() ? runs[i + 1].from : s.length();
+        const std::string_view window = s.substr(0, std::min(s.length(), bounds[i + 1] + old.length() - 1));
+        std::size_t read = runs[i].from, write = out_pos[i];
+        for (std::size_t n = 0; n < replacements[i]; ++n)
+        {
+            const std::size_t pos = search_helper(window, old, read);
+            std::memcpy(data + write, s.data() + read, pos - read);
+            write += pos - read;
+            std::memcpy(data + write, with.data(), with.length());
+            write += with.length();
+            read = pos + old.length();
+        }
+        std::memcpy(data + write, s.data() + read, end - read);
+    });
+    return out;
+}
+
+inline std::string replace(thread_pool& pool, std::string_view s, std::string_view old, std::string_view with, std::ptrdiff_t count = max_count)
+{
+    return replace_helper(pool, s, old, with, count);
+}
+
+inline std::string replace(thread_pool& pool, std::string_view s, const searcher& old, std::string_view with, std::ptrdiff_t count = max_count)
+{
+    return replace_helper(pool, s, old, with, count);
+}
+
+template<typename Fallback>
+std::string case_helper(thread_pool& pool, std::string_view s, bool flip_lower, bool flip_upper, Fallback fallback)
+{
+    std::string out(s.length(), '\0');
+    char* const data = &out[0];
+    const std::vector<std::size_t> bounds = chunk_bounds_helper(pool, s.length());
+    pool.run(bounds.size() - 1, [&](std::size_t i)
+    {
+        case_helper(s.substr(bounds[i], bounds[i + 1] - bounds[i]), data + bounds[i], flip_lower, flip_upper, fallback);
+    });
+    return out;
+}
+
+inline std::string lower(thread_pool& pool, std::string_view s)
 {
-    return rjust(s, width, '0');
+    return case_helper(pool, s, false, true, lower_helper);
+}
+
+inline std::string upper(thread_pool& pool, std::string_view s)
+{
+    return case_helper(pool, s, true, false, upper_helper);
+}
+
+// Chunks are translated in parallel, each into its own slice of the
+// result; when bytes are deleted the slices are then closed up in order.
+std::string translate(thread_pool& pool, std::string_view s, const translation& table);
+
+// Applies one operation, or a pipeline of them, to every string in a batch.
+// Inputs are handed to the pool's threads in blocks, and the result for
+// inputs[i] is always written to outputs[i].
+namespace batch {
+
+// Enough short strings per block to stay in cache, and few enough blocks
+// that threads finishing early can still pick up more work.
+const std::size_t default_block_size = 1024;
+
+// A contiguous run of elements, like C++20's std::span.
+template<typename T>
+class span
+{
+public:
+    span(T* data, std::size_t size)
+        :data_(data), size_(size)
+    {
+    }
+
+    template<typename Container>
+    span(Container& container)
+        :data_(container.data()), size_(container.size())
+    {
+    }
+
+    T* data() const
+    {
+        return data_;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    T& operator[](std::size_t i) const
+    {
+        return data_[i];
+    }
+
+private:
+    T* data_;
+    std::size_t size_;
+};
+
+// op may itself call the thread_pool overloads on the same pool; while
+// waiting for its blocks, each thread runs whatever else is queued.
+template<typename In, typename Out, typename Op>
+void apply(thread_pool& pool, span<const In> inputs, span<Out> outputs, Op op, std::size_t block_size = default_block_size)
+{
+    if (outputs.size() < inputs.size())
+    {
+        throw value_error("output span is smaller than input span");
+    }
+
+    block_size = std::max<std::size_t>(block_size, 1);
+    const std::size_t blocks = (inputs.size() + block_size - 1) / block_size;
+    pool.run(blocks, [&](std::size_t block)
+    {
+        const std::size_t end = std::min(inputs.size(), (block + 1) * block_size);
+        for (std::size_t i = block * block_size; i < end; ++i)
+        {
+            outputs[i] = op(inputs[i]);
+        }
+    });
+}
+
+template<typename InContainer, typename OutContainer, typename Op>
+void apply(thread_pool& pool, const InContainer& inputs, OutContainer& outputs, Op op, std::size_t block_size = default_block_size)
+{
+    apply(pool,
+          span<const typename InContainer::value_type>(inputs),
+          span<typename OutContainer::value_type>(outputs),
+          op, block_size);
+}
+
+// Each operation takes any string-like input and returns a std::string,
+// reusing the buffer of one it is handed by a previous stage.
+class strip_t
+{
+public:
+    explicit strip_t(const charset& chars)
+        :chars_(chars)
+    {
+    }
+
+    template<typename S>
+    std::string operator()(S&& s) const
+    {
+        return string_utils::strip(std::string(std::forward<S>(s)), chars_);
+    }
+
+private:
+    charset chars_;
+};
+
+class lstrip_t
+{
+public:
+    explicit lstrip_t(const charset& chars)
+        :chars_(chars)
+    {
+    }
+
+    template<typename S>
+    std::string operator()(S&& s) const
+    {
+        return string_utils::lstrip(std::string(std::forward<S>(s)), chars_);
+    }
+
+private:
+    charset chars_;
+};
+
+class rstrip_t
+{
+public:
+    explicit rstrip_t(const charset& chars)
+        :chars_(chars)
+    {
+    }
+
+    template<typename S>
+    std::string operator()(S&& s) const
+    {
+        return string_utils::rstrip(std::string(std::forward<S>(s)), chars_);
+    }
+
+private:
+    charset chars_;
+};
+
+struct lower_t
+{
+    template<typename S>
+    std::string operator()(S&& s) const
+    {
+        return string_utils::lower(std::string(std::forward<S>(s)));
+    }
+};
+
+struct upper_t
+{
+    template<typename S>
+    std::string operator()(S&& s) const
+    {
+        return string_utils::upper(std::string(std::forward<S>(s)));
+    }
+};
+
+class replace_t
+{
+public:
+    replace_t(std::string_view old, std::string_view with, std::ptrdiff_t count)
+        :old_(old), with_(with), count_(count)
+    {
+    }
+
+    template<typename S>
+    std::string operator()(S&& s) const
+    {
+        return string_utils::replace(std::string(std::forward<S>(s)), old_, with_, count_);
+    }
+
+private:
+    searcher old_;
+    std::string with_;
+    std::ptrdiff_t count_;
+};
+
+class translate_t
+{
+public:
+    explicit translate_t(const translation& table)
+        :table_(table)
+    {
+    }
+
+    template<typename S>
+    std::string operator()(S&& s) const
+    {
+        return string_utils::translate(std::string(std::forward<S>(s)), table_);
+    }
+
+private:
+    translation table_;
+};
+
+class split_t
+{
+public:
+    split_t(std::string_view sep, std::ptrdiff_t max_split)
+        :sep_(sep), max_split_(max_split)
+    {
+    }
+
+    string_list operator()(std::string_view s) const
+    {
+        return string_utils::split(s, sep_, max_split_);
+    }
+
+private:
+    searcher sep_;
+    std::ptrdiff_t max_split_;
+};
+
+inline strip_t strip(const charset& chars = strip_chars)
+{
+    return strip_t(chars);
+}
+
+inline lstrip_t lstrip(const charset& chars = strip_chars)
+{
+    return lstrip_t(chars);
+}
+
+inline rstrip_t rstrip(const charset& chars = strip_chars)
+{
+    return rstrip_t(chars);
+}
+
+inline lower_t lower()
+{
+    return lower_t();
+}
+
+inline upper_t upper()
+{
+    return upper_t();
+}
+
+inline replace_t replace(std::string_view old, std::string_view with, std::ptrdiff_t count = max_count)
+{
+    return replace_t(old, with, count);
+}
+
+inline translate_t translate(const translation& table)
+{
+    return translate_t(table);
+}
+
+inline split_t split(std::string_view sep, std::ptrdiff_t max_split = max_count)
+{
+    return split_t(sep, max_split);
+}
+
+// pipeline(f, g, h)(s) is h(g(f(s))).
+template<typename Op>
+Op pipeline(Op op)
+{
+    return op;
+}
+
+template<typename Op, typename... Ops>
+auto pipeline(Op op, Ops... ops)
+{
+    return [op, rest = pipeline(ops...)](auto&& input)
+    {
+        return rest(op(std::forward<decltype(input)>(input)));
+    };
+}
+
+}
+
+// Allocator-aware variants. Results, including every string inside a list,
+// are allocated from the given memory resource, so a whole batch of results
+// can live in one arena and be released together.
+namespace pmr {
+
+typedef std::pmr::string string;
+typedef std::pmr::list<string> string_list;
+
+struct partition_t
+{
+    string head, sep, tail;
+};
+
+partition_t partition_helper(const partition_view_t& partitioned, std::pmr::memory_resource* resource);
+
+template<typename Range>
+string_list string_list_helper(const Range& range, std::pmr::memory_resource* resource)
+{
+    string_list result(resource);
+    for (typename Range::const_iterator current = range.begin(), end = range.end(); current != end; ++current)
+    {
+        result.emplace_back(*current);
+    }
+    return result;
+}
+
+inline partition_t partition(std::string_view s, std::string_view sep, std::pmr::memory_resource* resource)
+{
+    return partition_helper(partition_view(s, sep), resource);
+}
+
+inline partition_t partition(std::string_view s, const searcher& sep, std::pmr::memory_resource* resource)
+{
+    return partition_helper(partition_view(s, sep), resource);
+}
+
+inline partition_t rpartition(std::string_view s, std::string_view sep, std::pmr::memory_resource* resource)
+{
+    return partition_helper(rpartition_view(s, sep), resource);
+}
+
+inline partition_t rpartition(std::string_view s, const searcher& sep, std::pmr::memory_resource* resource)
+{
+    return partition_helper(rpartition_view(s, sep), resource);
+}
+
+inline string replace(std::string_view s, std::string_view old, std::string_view with, std::pmr::memory_resource* resource, std::ptrdiff_t count = max_count)
+{
+    return replace_helper(string(s, resource), old, with, count);
+}
+
+inline string replace(std::string_view s, const searcher& old, std::string_view with, std::pmr::memory_resource* resource, std::ptrdiff_t count = max_count)
+{
+    return replace_helper(string(s, resource), old, with, count);
+}
+
+template<typename C>
+string join(std::string_view s, const C& container, std::pmr::memory_resource* resource)
+{
+    string joined(resource);
+    join_helper(joined, s, container);
+    return joined;
+}
+
+inline string_list split(std::string_view s, std::pmr::memory_resource* resource)
+{
+    return string_list_helper(whitespace_split_range(s), resource);
+}
+
+inline string_list split(std::string_view s, std::string_view sep, std::pmr::memory_resource* resource, std::ptrdiff_t max_split = max_count)
+{
+    return string_list_helper(split_range(s, sep, max_split), resource);
+}
+
+inline string_list split(std::string_view s, const searcher& sep, std::pmr::memory_resource* resource, std::ptrdiff_t max_split = max_count)
+{
+    return string_list_helper(split_range(s, sep, max_split), resource);
+}
+
+inline string_list rsplit(std::string_view s, std::pmr::memory_resource* resource)
+{
+    return split(s, resource);
+}
+
+inline string_list rsplit(std::string_view s, std::string_view sep, std::pmr::memory_resource* resource, std::ptrdiff_t max_split = max_count)
+{
+    return string_list_helper(rsplit_view_helper(s, sep, max_split), resource);
+}
+
+inline string_list rsplit(std::string_view s, const searcher& sep, std::pmr::memory_resource* resource, std::ptrdiff_t max_split = max_count)
+{
+    return string_list_helper(rsplit_view_helper(s, sep, max_split), resource);
+}
+
+inline string_list splitlines(std::string_view s, std::pmr::memory_resource* resource, bool keepends = false)
+{
+    return string_list_helper(lines_range(s, keepends), resource);
+}
+
+template<typename Fallback>
+string case_helper(std::string_view s, std::pmr::memory_resource* resource, bool flip_lower, bool flip_upper, Fallback fallback)
+{
+    string out(s.length(), '\0', resource);
+    string_utils::case_helper(s, &out[0], flip_lower, flip_upper, fallback);
+    return out;
+}
+
+inline string lower(std::string_view s, std::pmr::memory_resource* resource)
+{
+    return case_helper(s, resource, false, true, lower_helper);
+}
+
+inline string upper(std::string_view s, std::pmr::memory_resource* resource)
+{
+    return case_helper(s, resource, true, false, upper_helper);
+}
+
+inline string swapcase(std::string_view s, std::pmr::memory_resource* resource)
+{
+    return case_helper(s, resource, true, true, swapcase_helper);
+}
+
+inline string title(std::string_view s, std::pmr::memory_resource* resource)
+{
+    string titlecased(s, resource);
+    std::transform(titlecased.begin(), titlecased.end(), titlecased.begin(), titlecase_helper());
+    return titlecased;
+}
+
+inline string lstrip(std::string_view s, std::pmr::memory_resource* resource, const charset& chars = strip_chars)
+{
+    return string(lstrip_view(s, chars), resource);
+}
+
+inline string rstrip(std::string_view s, std::pmr::memory_resource* resource, const charset& chars = strip_chars)
+{
+    return string(rstrip_view(s, chars), resource);
+}
+
+inline string strip(std::string_view s, std::pmr::memory_resource* resource, const charset& chars = strip_chars)
+{
+    return string(strip_view(s, chars), resource);
+}
+
+inline string pad_helper(std::string_view s, int width, char fill, alignment_t alignment, std::pmr::memory_resource* resource)
+{
+    string out(resource);
+    out.reserve(std::max<std::ptrdiff_t>(width, s.length()));
+    string_utils::pad_helper(out, s, width, fill, alignment);
+    return out;
+}
+
+inline string ljust(std::string_view s, int width, std::pmr::memory_resource* resource, char fillchar = ' ')
+{
+    return pad_helper(s, width, fillchar, align_left, resource);
+}
+
+inline string rjust(std::string_view s, int width, std::pmr::memory_resource* resource, char fillchar = ' ')
+{
+    return pad_helper(s, width, fillchar, align_right, resource);
+}
+
+inline string center(std::string_view s, int width, std::pmr::memory_resource* resource, char fill = ' ')
+{
+    return pad_helper(s, width, fill, align_center, resource);
+}
+
+inline string zfill(std::string_view s, int width, std::pmr::memory_resource* resource)
+{
+    return rjust(s, width, resource, '0');
+}
+
+inline string expandtabs(std::string_view s, std::pmr::memory_resource* resource, int tabsize = 8)
+{
+    std::size_t column = 0;
+    string expanded(expandtabs_size_helper(s, tabsize, column), '\0', resource);
+    column = 0;
+    expandtabs_helper(s.data(), s.data() + s.length(), &expanded[0], tabsize, column);
+    return expanded;
+}
+
+inline string translate(std::string_view s, const translation& table, std::pmr::memory_resource* resource)
+{
+    string translated(s.length(), '\0', resource);
+    char* const first = &translated[0];
+    translated.resize(table.apply(s.data(), s.data() + s.length(), first) - first);
+    return translated;
+}
+
 }
 
 }
@@ -1,12 +1,127 @@
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <deque>
 #include <list>
+#include <locale>
+#include <memory_resource>
+#include <new>
+#include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <system_error>
+
+#include <unistd.h>
 
 #include <unittest++/UnitTest++.h>
 
 #include <string_utils.h>
 
+namespace {
+
+std::atomic<long> allocations(0);
+
+}
+
+// Counts every allocation made while the tests run, so that
+// CHECK_ALLOCATIONS can hold a call to an allocation budget.
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size > 0 ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Not inlined, or GCC sees free() called on the result of operator new.
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// Fails unless evaluating expression makes at most budget allocations.
+#define CHECK_ALLOCATIONS(budget, expression) \
+    do \
+    { \
+        const long allocations_before = allocations.load(); \
+        (void)(expression); \
+        const long allocations_made = allocations.load() - allocations_before; \
+        CHECK_EQUAL(std::min<long>(allocations_made, budget), allocations_made); \
+    } while (0)
+
+namespace {
+
+const std::string long_text("  The Quick Brown Fox, Jumps Over, The Lazy Dog  ");
+
+}
+
+TEST(AllocationBudgetViews)
+{
+    CHECK_ALLOCATIONS(0, string_utils::find(long_text, "Lazy"));
+    CHECK_ALLOCATIONS(0, string_utils::count(long_text, "o"));
+    CHECK_ALLOCATIONS(0, string_utils::startswith(long_text, "  The"));
+    CHECK_ALLOCATIONS(0, string_utils::isalpha(long_text));
+    CHECK_ALLOCATIONS(0, string_utils::strip_view(long_text));
+    CHECK_ALLOCATIONS(0, string_utils::partition_view(long_text, ","));
+    CHECK_ALLOCATIONS(0, string_utils::split_range(long_text, ",").begin());
+    CHECK_ALLOCATIONS(0, string_utils::split_each(long_text, ",", [](std::string_view) {}));
+}
+
+TEST(AllocationBudgetCopies)
+{
+    CHECK_ALLOCATIONS(1, string_utils::upper(long_text));
+    CHECK_ALLOCATIONS(1, string_utils::lower(long_text));
+    CHECK_ALLOCATIONS(1, string_utils::swapcase(long_text));
+    CHECK_ALLOCATIONS(1, string_utils::title(long_text));
+    CHECK_ALLOCATIONS(1, string_utils::capitalize(long_text));
+    CHECK_ALLOCATIONS(1, string_utils::strip(long_text));
+    CHECK_ALLOCATIONS(1, string_utils::center(long_text, 80));
+    CHECK_ALLOCATIONS(1, string_utils::ljust(long_text, 80));
+    CHECK_ALLOCATIONS(1, string_utils::rjust(long_text, 80));
+    CHECK_ALLOCATIONS(1, string_utils::zfill(long_text, 80));
+    CHECK_ALLOCATIONS(1, string_utils::expandtabs(long_text));
+    CHECK_ALLOCATIONS(1, string_utils::replace(long_text, "The", "A"));
+    CHECK_ALLOCATIONS(1, string_utils::translate(long_text, string_utils::translation()));
+}
+
+TEST(AllocationBudgetMovesAndInPlace)
+{
+    std::string s(long_text);
+    CHECK_ALLOCATIONS(0, string_utils::upper_inplace(s));
+    CHECK_ALLOCATIONS(0, string_utils::strip_inplace(s));
+    CHECK_ALLOCATIONS(0, string_utils::translate_inplace(s, string_utils::translation()));
+    CHECK_ALLOCATIONS(0, s = string_utils::lower(std::move(s)));
+    CHECK_ALLOCATIONS(0, s = string_utils::title(std::move(s)));
+}
+
+TEST(AllocationBudgetContainers)
+{
+    // One node per field, plus a buffer for the only field too long for the
+    // small string optimisation.
+    CHECK_ALLOCATIONS(4, string_utils::split(long_text, ","));
+
+    const string_utils::string_view_list views = string_utils::split_view(long_text, ",");
+    CHECK_ALLOCATIONS(1, string_utils::join(",", views));
+
+    std::vector<std::string_view> fields;
+    fields.reserve(3);
+    CHECK_ALLOCATIONS(0, string_utils::split(long_text, ",", std::back_inserter(fields)));
+
+    char buffer[1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer, std::pmr::null_memory_resource());
+    CHECK_ALLOCATIONS(0, string_utils::pmr::split(long_text, ",", &arena));
+}
+
 TEST(CapitalizeString)
 {
     CHECK_EQUAL("All lowercase", string_utils::capitalize("all lowercase"));
@@ -62,6 +177,13 @@ TEST(CenterStringWithNegativeWidth)
     CHECK_EQUAL("tiger", string_utils::center("tiger", -1));
 }
 
+TEST(CenterInPlace)
+{
+    std::string s("abc");
+    string_utils::center_inplace(s, 8, '*');
+    CHECK_EQUAL("**abc***", s);
+}
+
 TEST(CountCharsInAString)
 {
     CHECK_EQUAL(13, string_utils::count("nnnnnnnnnnnnn", "n"));
@@ -82,6 +204,13 @@ TEST(CountSubstringsEndingingMidway)
     CHECK_EQUAL(1, string_utils::count("the cat with the hat sat on the mat", "the", 4, 28));
 }
 
+TEST(CountSubstringsWithSearcher)
+{
+    const string_utils::searcher searcher("the");
+    CHECK_EQUAL(3, string_utils::count("the cat with the hat sat on the mat", searcher));
+    CHECK_EQUAL(1, string_utils::count("the cat with the hat sat on the mat", searcher, 4, 28));
+}
+
 TEST(EndsWithPositive)
 {
     CHECK_EQUAL(true, string_utils::endswith("contraband", "band"));
@@ -141,6 +270,57 @@ TEST(ExpandTabsAccountsForNewlines)
                 "x               y", returned);
 }
 
+TEST(ExpandTabsLongLines)
+{
+    std::string s, expected;
+    for (int i = 0; i < 40; ++i)
+    {
+        s += std::string(i, 'x') + "\t" + (i % 5 == 0 ? "\r\n" : "");
+        expected += std::string(i, 'x');
+        const std::string::size_type column = expected.length() - (expected.find_last_of("\n") + 1);
+        expected += std::string(4 - column % 4, ' ') + (i % 5 == 0 ? "\r\n" : "");
+    }
+    CHECK_EQUAL(expected, string_utils::expandtabs(s, 4));
+}
+
+TEST(TabExpanderCarriesColumnAcrossChunks)
+{
+    const std::string s = "ab\tc\td\nlonger line\tend\r\n\t\tx";
+    const std::string expected = string_utils::expandtabs(s, 4);
+    for (std::string::size_type chunk = 1; chunk <= s.length(); ++chunk)
+    {
+        string_utils::tab_expander expander(4);
+        std::string out;
+        for (std::string::size_type pos = 0; pos < s.length(); pos += chunk)
+        {
+            expander.expand(std::string_view(s).substr(pos, chunk), out);
+        }
+        CHECK_EQUAL(expected, out);
+        CHECK_EQUAL(9U, expander.column());
+    }
+}
+
+TEST(ExpandTabsInPlace)
+{
+    std::string grows("xxxxxxx\ty\nx\t\ty");
+    string_utils::expandtabs_inplace(grows);
+    CHECK_EQUAL("xxxxxxx y\nx               y", grows);
+
+    std::string shrinks("a\tb\tc");
+    string_utils::expandtabs_inplace(shrinks, 0);
+    CHECK_EQUAL("abc", shrinks);
+}
+
+TEST(ExpandTabsConsumingReusesBuffer)
+{
+    std::string s("ab\tc");
+    s.reserve(64);
+    const char* const buffer = s.data();
+    const std::string expanded = string_utils::expandtabs(std::move(s), 4);
+    CHECK_EQUAL("ab  c", expanded);
+    CHECK(buffer == expanded.data());
+}
+
 TEST(FindSubstringPositive)
 {
     CHECK_EQUAL(18, string_utils::find("A haystack with a needle", "needle"));
@@ -163,6 +343,126 @@ TEST(FindSubstringWithEndPosition)
     CHECK_EQUAL(-1, string_utils::find("Needle", "Needle", 0, 4));
 }
 
+TEST(FindSubstringAcrossBlocks)
+{
+    const std::string haystack = std::string(100, 'x') + "needle" + std::string(100, 'x');
+    CHECK_EQUAL(100, string_utils::find(haystack, "needle"));
+    CHECK_EQUAL(100, string_utils::rfind(haystack, "needle"));
+    CHECK_EQUAL(-1, string_utils::find(haystack, "needle", 101));
+}
+
+TEST(SearchHelperAgreesWithStdString)
+{
+    std::string haystack;
+    for (int i = 0; i < 150; ++i)
+    {
+        haystack.push_back("aab"[(i * 7) % 3]);
+    }
+    const char* const needles[] = { "", "a", "b", "ab", "aab", "baa", "abaab", "aabaabaab", "c", "aabc" };
+    for (const char* needle : needles)
+    {
+        for (std::string::size_type pos = 0; pos <= haystack.size() + 1; ++pos)
+        {
+            CHECK_EQUAL(haystack.find(needle, pos), string_utils::search_helper(haystack, needle, pos));
+            CHECK_EQUAL(haystack.rfind(needle, pos), string_utils::rsearch_helper(haystack, needle, pos));
+        }
+    }
+}
+
+TEST(SearcherAgreesWithStdString)
+{
+    std::string haystack;
+    for (int i = 0; i < 150; ++i)
+    {
+        haystack.push_back("aab"[(i * 7) % 3]);
+    }
+    const char* const needles[] = { "", "a", "b", "ab", "aab", "baa", "abaab", "aabaabaab", "c", "aabc", "abababab" };
+    for (const char* needle : needles)
+    {
+        const string_utils::searcher searcher(needle);
+        for (std::string::size_type pos = 0; pos <= haystack.size() + 1; ++pos)
+        {
+            CHECK_EQUAL(haystack.find(needle, pos), searcher.find_in(haystack, pos));
+            CHECK_EQUAL(haystack.rfind(needle, pos), searcher.rfind_in(haystack, pos));
+        }
+    }
+}
+
+TEST(SearcherAdversarialInput)
+{
+    const std::string haystack = std::string(1 << 20, 'a') + "b";
+    const std::string needle = std::string(1 << 10, 'a') + "b";
+    const string_utils::searcher searcher(needle);
+    CHECK_EQUAL(haystack.size() - needle.size(), searcher.find_in(haystack));
+    CHECK_EQUAL(-1, string_utils::find(haystack, string_utils::searcher("ab" + std::string(1 << 10, 'a'))));
+}
+
+TEST(FindAndReverseFindWithSearcher)
+{
+    const string_utils::searcher searcher("baa");
+    CHECK_EQUAL(0, string_utils::find("baa baa black sheep", searcher));
+    CHECK_EQUAL(4, string_utils::rfind("baa baa black sheep", searcher));
+    CHECK_EQUAL(-1, string_utils::rfind("baa baa black sheep", searcher, 5));
+}
+
+TEST(FixedStringAtCompileTime)
+{
+    constexpr auto hello = string_utils::upper(string_utils::strip(string_utils::fixed("  hello  ")));
+    static_assert(hello.view() == "HELLO", "upper and strip are constant expressions");
+    static_assert(string_utils::lower(string_utils::fixed("MiXeD 42")).view() == "mixed 42", "lower is a constant expression");
+    static_assert(string_utils::center<7>(string_utils::fixed("ab"), '*').view() == "**ab***", "center is a constant expression");
+    static_assert(string_utils::zfill<5>(string_utils::fixed("42")).view() == "00042", "zfill is a constant expression");
+    static_assert(string_utils::replace(string_utils::fixed("a-b-c"), string_utils::fixed("-"), string_utils::fixed("--")).view() == "a--b--c",
+                  "replace is a constant expression");
+    static_assert(string_utils::replace(string_utils::fixed("a-b-c"), string_utils::fixed("-"), string_utils::fixed("--")).capacity() == 17,
+                  "replace sizes its result from its arguments");
+    CHECK_EQUAL("HELLO", hello.c_str());
+    CHECK_EQUAL(5U, hello.size());
+}
+
+TEST(FixedStringAgreesWithRuntime)
+{
+    constexpr auto s = string_utils::fixed(" Ab-cD-eF\t ");
+    CHECK_EQUAL(string_utils::upper(std::string(s)), std::string(string_utils::upper(s)));
+    CHECK_EQUAL(string_utils::lower(std::string(s)), std::string(string_utils::lower(s)));
+    CHECK_EQUAL(string_utils::lstrip(std::string(s)), std::string(string_utils::lstrip(s)));
+    CHECK_EQUAL(string_utils::rstrip(std::string(s), " \t"), std::string(string_utils::rstrip(s, " \t")));
+    CHECK_EQUAL(string_utils::ljust(std::string(s), 15, '.'), std::string(string_utils::ljust<15>(s, '.')));
+    CHECK_EQUAL(string_utils::rjust(std::string(s), 15), std::string(string_utils::rjust<15>(s)));
+    CHECK_EQUAL(string_utils::center(std::string(s), 17), std::string(string_utils::center<17>(s)));
+    CHECK_EQUAL(string_utils::center(std::string(s), 4), std::string(string_utils::center<4>(s)));
+    CHECK_EQUAL(string_utils::replace(std::string(s), "-", "+++", 1),
+                std::string(string_utils::replace(s, string_utils::fixed("-"), string_utils::fixed("+++"), 1)));
+    CHECK_EQUAL(string_utils::replace(std::string(s), "", "|"),
+                std::string(string_utils::replace(s, string_utils::fixed(""), string_utils::fixed("|"))));
+    CHECK_EQUAL(string_utils::replace(std::string(s), "", "|", 2),
+                std::string(string_utils::replace(s, string_utils::fixed(""), string_utils::fixed("|"), 2)));
+}
+
+TEST(FixedStringReplaceShorterOld)
+{
+    constexpr auto doubled = string_utils::replace(string_utils::fixed("aaaa"), string_utils::strip(string_utils::fixed(" a ")), string_utils::fixed("bb"));
+    static_assert(doubled.view() == "bbbbbbbb", "old may be shorter than its capacity");
+    constexpr auto between = string_utils::replace(string_utils::fixed("ab"), string_utils::strip(string_utils::fixed("  ")), string_utils::fixed("x"));
+    static_assert(between.view() == "xaxbx", "old may strip to empty");
+    CHECK_EQUAL("bbbbbbbb", doubled.c_str());
+    CHECK_EQUAL("xaxbx", between.c_str());
+}
+
+TEST(FixedStringCapacityExceededThrows)
+{
+    CHECK_THROW(string_utils::fixed_string<3>(std::string_view("abcd")), string_utils::value_error);
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+TEST(FixedStringLiteral)
+{
+    using namespace string_utils::literals;
+    static_assert(string_utils::upper("abc"_fs).view() == "ABC", "_fs makes a fixed_string");
+    CHECK_EQUAL(3U, "abc"_fs.size());
+}
+#endif
+
 TEST(GetIndexOfSubstringThrows)
 {
     CHECK_THROW(string_utils::index("The Holy Hand Grenade", "Antioch"), string_utils::value_error);
@@ -325,6 +625,46 @@ TEST(IdentifyUppercasePositive)
     CHECK_EQUAL(true, string_utils::isupper("UPPERCASE"));
 }
 
+TEST(ClassificationAgreesWithCLocale)
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        const std::string run(70, static_cast<char>(i));
+        CHECK_EQUAL(::isalnum(i) != 0, string_utils::isalnum(run));
+        CHECK_EQUAL(::isalpha(i) != 0, string_utils::isalpha(run));
+        CHECK_EQUAL(::isdigit(i) != 0, string_utils::isdigit(run));
+        CHECK_EQUAL(::islower(i) != 0, string_utils::islower(run));
+        CHECK_EQUAL(::isspace(i) != 0, string_utils::isspace(run));
+        CHECK_EQUAL(::isupper(i) != 0, string_utils::isupper(run));
+    }
+}
+
+TEST(ClassificationRejectsAnyPosition)
+{
+    const std::string digits(70, '7');
+    CHECK(string_utils::isdigit(digits));
+    for (std::string::size_type pos = 0; pos < digits.length(); ++pos)
+    {
+        std::string s(digits);
+        s[pos] = '\xb7';
+        CHECK(!string_utils::isdigit(s));
+        s[pos] = ':';
+        CHECK(!string_utils::isdigit(s));
+    }
+}
+
+TEST(ClassificationWithLocale)
+{
+    const std::locale& classic = std::locale::classic();
+    CHECK(string_utils::isalnum("Grenade69", classic));
+    CHECK(!string_utils::isalpha("Grenade69", classic));
+    CHECK(string_utils::isdigit("0123", classic));
+    CHECK(string_utils::islower("lower", classic));
+    CHECK(string_utils::isspace(" \t\r\n", classic));
+    CHECK(string_utils::isupper("UPPER", classic));
+    CHECK(!string_utils::isupper("", classic));
+}
+
 TEST(JoinListOfSingleString)
 {
     std::list<std::string> list_of_strings;
@@ -373,6 +713,36 @@ TEST(JoinArrayOfChar)
     CHECK_EQUAL("a b c d e f", string_utils::join(" ", "abcdef"));
 }
 
+TEST(JoinEmptyContainer)
+{
+    CHECK_EQUAL("", string_utils::join(",", std::vector<std::string>()));
+    CHECK_EQUAL("", string_utils::join(",", std::list<int>()));
+}
+
+TEST(JoinStringLikeItems)
+{
+    std::vector<std::string_view> views;
+    views.push_back("the first item");
+    views.push_back("");
+    views.push_back("the third item");
+    const std::string joined = string_utils::join(", ", views);
+    CHECK_EQUAL("the first item, , the third item", joined);
+    CHECK_EQUAL(joined.length(), joined.capacity());
+
+    std::vector<const char*> c_strings;
+    c_strings.push_back("x");
+    c_strings.push_back("y");
+    CHECK_EQUAL("x->y", string_utils::join("->", c_strings));
+}
+
+TEST(JoinFormatsOtherItems)
+{
+    std::vector<int> numbers;
+    numbers.push_back(10);
+    numbers.push_back(-2);
+    CHECK_EQUAL("10 -2", string_utils::join(" ", numbers));
+}
+
 TEST(LeftJustifyStringShorterThanWidth)
 {
     CHECK_EQUAL("a   ", string_utils::ljust("a", 4));
@@ -388,11 +758,44 @@ TEST(LeftJustifyStringWithDifferentChar)
     CHECK_EQUAL("cxxxx", string_utils::ljust("c", 5, 'x'));
 }
 
+TEST(LeftJustifyInPlace)
+{
+    std::string s("abc");
+    string_utils::ljust_inplace(s, 5, '-');
+    CHECK_EQUAL("abc--", s);
+    CHECK_EQUAL("abc", string_utils::ljust(std::string("abc"), 2));
+}
+
 TEST(LowercaseString)
 {
     CHECK_EQUAL("lowercase", string_utils::lower("LOWERCASE"));
 }
 
+namespace {
+
+std::string every_byte_twice()
+{
+    std::string s;
+    for (int i = 0; i < 512; ++i)
+    {
+        s.push_back(static_cast<char>(i));
+    }
+    return s;
+}
+
+}
+
+TEST(LowercaseEveryByte)
+{
+    const std::string s = every_byte_twice();
+    std::string expected;
+    for (std::string::const_iterator current = s.begin(); current != s.end(); ++current)
+    {
+        expected.push_back(::tolower(static_cast<unsigned char>(*current)));
+    }
+    CHECK(expected == string_utils::lower(s));
+}
+
 TEST(LeftStripString)
 {
     CHECK_EQUAL("beard", string_utils::lstrip("    \t\r\nbeard"));
@@ -413,6 +816,14 @@ TEST(LeftStripStringEmpty)
     CHECK_EQUAL("", string_utils::lstrip(""));
 }
 
+TEST(LeftStripViewReferencesOriginal)
+{
+    const std::string s("  padded");
+    const std::string_view stripped = string_utils::lstrip_view(s);
+    CHECK_EQUAL("padded", stripped);
+    CHECK(s.data() + 2 == stripped.data());
+}
+
 TEST(PartitionStringEmpty)
 {
     string_utils::partition_t partition = string_utils::partition("", ",");
@@ -445,6 +856,30 @@ TEST(PartitionSecondStringPositive)
     CHECK_EQUAL("Value: Second", partition.tail);
 }
 
+TEST(PartitionViewPositive)
+{
+    string_utils::partition_view_t partition = string_utils::partition_view("Key: Value", ": ");
+    CHECK_EQUAL("Key", partition.head);
+    CHECK_EQUAL(": ", partition.sep);
+    CHECK_EQUAL("Value", partition.tail);
+}
+
+TEST(PartitionViewNegative)
+{
+    string_utils::partition_view_t partition = string_utils::partition_view("The Division Bell", "/");
+    CHECK_EQUAL("The Division Bell", partition.head);
+    CHECK(partition.sep.empty());
+    CHECK(partition.tail.empty());
+}
+
+TEST(PartitionWithSearcher)
+{
+    string_utils::partition_t partition = string_utils::partition("Key: Value: Second", string_utils::searcher(": "));
+    CHECK_EQUAL("Key", partition.head);
+    CHECK_EQUAL(": ", partition.sep);
+    CHECK_EQUAL("Value: Second", partition.tail);
+}
+
 TEST(ReplaceEmpty)
 {
     CHECK_EQUAL("", string_utils::replace("", "Something", "Nothing", 2));
@@ -466,6 +901,125 @@ TEST(ReplaceStrings)
                 string_utils::replace("the cat sat on the mat", "the", "another"));
 }
 
+TEST(ReplaceWithShorterString)
+{
+    CHECK_EQUAL("a cat sat on a mat", string_utils::replace("the cat sat on the mat", "the", "a"));
+}
+
+TEST(ReplaceDeletes)
+{
+    CHECK_EQUAL("the cat sat on the mat", string_utils::replace("the cat sat on the mat!!!", "!", ""));
+}
+
+TEST(ReplaceRestartsAfterReplacement)
+{
+    CHECK_EQUAL("baaaa", string_utils::replace("aaaa", "aa", "baa", 1));
+    CHECK_EQUAL("aa", string_utils::replace("aaaa", "aa", "a"));
+}
+
+TEST(ReplaceEmptyOldInsertsBetweenCharacters)
+{
+    CHECK_EQUAL("-a-b-c-", string_utils::replace("abc", "", "-"));
+    CHECK_EQUAL("-a-bc", string_utils::replace("abc", "", "-", 2));
+}
+
+namespace {
+
+double replace_seconds(int matches)
+{
+    std::string s;
+    for (int i = 0; i < matches; ++i)
+    {
+        s += "word\t";
+    }
+
+    double best = 0;
+    for (int attempt = 0; attempt < 3; ++attempt)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const std::string replaced = string_utils::replace(s, "\t", "    ");
+        const std::string compacted = string_utils::replace(s, "word", "w");
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        CHECK_EQUAL(s.size() + 3 * matches, replaced.size());
+        CHECK_EQUAL(s.size() - 3 * matches, compacted.size());
+        if (attempt == 0 || elapsed.count() < best)
+        {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+}
+
+TEST(ReplaceScalesLinearly)
+{
+    const double small = replace_seconds(1 << 15);
+    const double large = replace_seconds(1 << 18);
+    CHECK(large < 24 * small);
+}
+
+TEST(NegativeCountsMeanNoLimit)
+{
+    CHECK_EQUAL("bbb", string_utils::replace("aaa", "a", "b", -1));
+    CHECK_EQUAL("bbb", string_utils::replace("aaa", "a", "b", -7));
+    CHECK_EQUAL("-a-a-", string_utils::replace("aa", "", "-", -1));
+    CHECK_EQUAL("bbb", string_utils::replace("aaa", "a", "b", std::ptrdiff_t(1) << 40));
+    CHECK_EQUAL("xx", string_utils::replace_many("aa", {{"a", "x", -1}}));
+    CHECK_EQUAL(3U, string_utils::split("a,b,c", ",", -1).size());
+    CHECK_EQUAL(3U, string_utils::rsplit("a,b,c", ",", -3).size());
+    CHECK_EQUAL(3U, string_utils::split_any("a,b;c", ",;", -1).size());
+    CHECK_EQUAL("bbb", std::string(string_utils::replace(string_utils::fixed("aaa"), string_utils::fixed("a"), string_utils::fixed("b"), -1)));
+}
+
+TEST(ReplaceWithSearcher)
+{
+    const string_utils::searcher searcher("\t");
+    CHECK_EQUAL("a b c\td", string_utils::replace("a\tb\tc\td", searcher, " ", 2));
+}
+
+TEST(ReplaceMany)
+{
+    CHECK_EQUAL("the dog sat on the rug",
+                string_utils::replace_many("the cat sat on the mat", {{"cat", "dog"}, {"mat", "rug"}}));
+}
+
+TEST(ReplaceManyIsSinglePass)
+{
+    CHECK_EQUAL("ba", string_utils::replace_many("ab", {{"a", "b"}, {"b", "a"}}));
+}
+
+TEST(ReplaceManyLeftmostLongest)
+{
+    CHECK_EQUAL("[her]s [her] s[he]",
+                string_utils::replace_many("hers her she", {{"he", "[he]"}, {"her", "[her]"}, {"rs her", "never"}}));
+    CHECK_EQUAL("x<abcd>", string_utils::replace_many("xabcd", {{"bc", "<bc>"}, {"abcd", "<abcd>"}, {"ab", "<ab>"}}));
+}
+
+TEST(ReplaceManyWithCounts)
+{
+    CHECK_EQUAL("2 1 c", string_utils::replace_many("c c c c", {{"c", "1", 1}, {"c c", "2", 1}}));
+    CHECK_EQUAL("sneeze", string_utils::replace_many("sneeze", {{"e", "o", 0}}));
+}
+
+TEST(ReplaceManyDuplicatePattern)
+{
+    CHECK_EQUAL("xaa", string_utils::replace_many("aaa", {{"a", "x", 1}, {"a", "y"}}));
+    CHECK_EQUAL("xzab", string_utils::replace_many("abab", {{"a", "x", 1}, {"b", "z", 1}, {"a", "y"}}));
+}
+
+TEST(ReplacerReused)
+{
+    const string_utils::replacer replacer({{"\t", " "}, {"\r\n", "\n"}});
+    CHECK_EQUAL("a b\n", string_utils::replace_many("a\tb\r\n", replacer));
+    CHECK_EQUAL("\n \r", string_utils::replace_many("\r\n\t\r", replacer));
+}
+
+TEST(ReplaceManyEmptyPatternThrows)
+{
+    CHECK_THROW(string_utils::replace_many("abc", {{"", "x"}}), string_utils::value_error);
+}
+
 TEST(ReverseFindEmpty)
 {
     CHECK_EQUAL(9, string_utils::rfind("something", ""));
@@ -531,6 +1085,14 @@ TEST(RightJustifyStringWithDifferentChar)
     CHECK_EQUAL("xxxxc", string_utils::rjust("c", 5, 'x'));
 }
 
+TEST(RightJustifyInPlace)
+{
+    std::string s("abc");
+    string_utils::rjust_inplace(s, 5, '-');
+    CHECK_EQUAL("--abc", s);
+    CHECK_EQUAL("abc", string_utils::rjust(std::string("abc"), 2));
+}
+
 TEST(ReversePartitionStringEmpty)
 {
     string_utils::partition_t partition = string_utils::rpartition("", ",");
@@ -555,6 +1117,16 @@ TEST(ReversePartitionSecondStringPositive)
     CHECK_EQUAL("Second", partition.tail);
 }
 
+TEST(ReversePartitionViewPositive)
+{
+    const std::string s("Key: Value: Second");
+    string_utils::partition_view_t partition = string_utils::rpartition_view(s, ": ");
+    CHECK_EQUAL("Key: Value", partition.head);
+    CHECK_EQUAL(": ", partition.sep);
+    CHECK_EQUAL("Second", partition.tail);
+    CHECK(s.data() + 12 == partition.tail.data());
+}
+
 TEST(ReverseSplitEmptySeperatorThrows)
 {
     CHECK_THROW(string_utils::rsplit("", ""), string_utils::value_error);
@@ -674,6 +1246,31 @@ TEST(ReverseSplitNothingBetweenSeparators)
     CHECK_EQUAL("7", returned.front()); returned.pop_front();
 }
 
+TEST(ReverseSplitLeadingSeparatorAndTwoWords)
+{
+    string_utils::string_list returned = string_utils::rsplit(":a:b", ":");
+    CHECK_EQUAL(3U, returned.size());
+    CHECK_EQUAL("", returned.front()); returned.pop_front();
+    CHECK_EQUAL("a", returned.front()); returned.pop_front();
+    CHECK_EQUAL("b", returned.front()); returned.pop_front();
+}
+
+TEST(ReverseSplitLeadingSeparatorOnceOnly)
+{
+    string_utils::string_list returned = string_utils::rsplit(":a:b", ":", 1);
+    CHECK_EQUAL(2U, returned.size());
+    CHECK_EQUAL(":a", returned.front()); returned.pop_front();
+    CHECK_EQUAL("b", returned.front()); returned.pop_front();
+}
+
+TEST(ReverseSplitView)
+{
+    string_utils::string_view_list returned = string_utils::rsplit_view("Three, Dog, Night", ", ", 1);
+    CHECK_EQUAL(2U, returned.size());
+    CHECK_EQUAL("Three, Dog", returned[0]);
+    CHECK_EQUAL("Night", returned[1]);
+}
+
 TEST(RightStripString)
 {
     CHECK_EQUAL("tease", string_utils::rstrip("tease \t\r\n"));
@@ -777,6 +1374,90 @@ TEST(SplitOnlyAWordSurroundedBySpace)
     CHECK_EQUAL("word", returned.front()); returned.pop_front();
 }
 
+TEST(SplitNoSeparatorPresent)
+{
+    string_utils::string_list returned = string_utils::split("solitary", ",");
+    CHECK_EQUAL(1U, returned.size());
+    CHECK_EQUAL("solitary", returned.front());
+}
+
+TEST(SplitWithSearcher)
+{
+    const string_utils::searcher searcher(", ");
+    string_utils::string_list returned = string_utils::split("Three, Dog, Night", searcher);
+    CHECK_EQUAL(3U, returned.size());
+    CHECK_EQUAL("Three", returned.front()); returned.pop_front();
+    CHECK_EQUAL("Dog", returned.front()); returned.pop_front();
+    CHECK_EQUAL("Night", returned.front()); returned.pop_front();
+
+    returned = string_utils::rsplit("Three, Dog, Night", searcher, 1);
+    CHECK_EQUAL(2U, returned.size());
+    CHECK_EQUAL("Three, Dog", returned.front()); returned.pop_front();
+    CHECK_EQUAL("Night", returned.front()); returned.pop_front();
+}
+
+TEST(SplitView)
+{
+    const std::string s("Three, Dog, Night");
+    string_utils::string_view_list returned = string_utils::split_view(s, ", ");
+    CHECK_EQUAL(3U, returned.size());
+    CHECK_EQUAL("Three", returned[0]);
+    CHECK_EQUAL("Dog", returned[1]);
+    CHECK_EQUAL("Night", returned[2]);
+    CHECK(s.data() + 12 == returned[2].data());
+}
+
+TEST(SplitViewDefault)
+{
+    string_utils::string_view_list returned = string_utils::split_view("\tRapid\r\nEar  Movement\n");
+    CHECK_EQUAL(3U, returned.size());
+    CHECK_EQUAL("Rapid", returned[0]);
+    CHECK_EQUAL("Ear", returned[1]);
+    CHECK_EQUAL("Movement", returned[2]);
+}
+
+TEST(SplitRange)
+{
+    std::vector<std::string_view> returned;
+    for (std::string_view token : string_utils::split_range("four::dots", ":"))
+    {
+        returned.push_back(token);
+    }
+    CHECK_EQUAL(3U, returned.size());
+    CHECK_EQUAL("four", returned[0]);
+    CHECK_EQUAL("", returned[1]);
+    CHECK_EQUAL("dots", returned[2]);
+}
+
+TEST(SplitRangeOnceOnly)
+{
+    const string_utils::token_range<string_utils::separator_tokenizer> range =
+        string_utils::split_range("Three, Dog, Night", ", ", 1);
+    string_utils::token_range<string_utils::separator_tokenizer>::iterator current = range.begin();
+    CHECK_EQUAL("Three", *current++);
+    CHECK_EQUAL("Dog, Night", *current++);
+    CHECK(current == range.end());
+}
+
+TEST(SplitRangeStopsEarly)
+{
+    const std::string s("first,second,third");
+    CHECK_EQUAL("first", *string_utils::split_range(s, ",").begin());
+}
+
+TEST(SplitRangeEmptySeparatorThrows)
+{
+    CHECK_THROW(string_utils::split_range("abc", ""), string_utils::value_error);
+}
+
+TEST(WhitespaceSplitRange)
+{
+    const string_utils::token_range<string_utils::whitespace_tokenizer> range =
+        string_utils::whitespace_split_range("\tword  another\r\n");
+    CHECK_EQUAL(2, std::distance(range.begin(), range.end()));
+    CHECK_EQUAL("another", *++range.begin());
+}
+
 TEST(SplitLines)
 {
     string_utils::string_list returned = string_utils::splitlines("1. One\n2. Two\n3. Three\n");
@@ -822,6 +1503,218 @@ TEST(SplitLinesWithBlankLinesAndCarriageReturnsWithKeepEnds)
     CHECK_EQUAL("\r\n", returned.front()); returned.pop_front();
 }
 
+TEST(SplitToOutputIterator)
+{
+    std::vector<std::string> strings;
+    string_utils::split("a:b::c", ":", std::back_inserter(strings));
+    CHECK_EQUAL(4U, strings.size());
+    CHECK_EQUAL("", strings[2]);
+    CHECK_EQUAL("c", strings[3]);
+
+    std::vector<std::string_view> views;
+    views.reserve(8);
+    for (int i = 0; i < 2; ++i)
+    {
+        views.clear();
+        string_utils::split("a:b:c", string_utils::searcher(":"), std::back_inserter(views), 1);
+        CHECK_EQUAL(2U, views.size());
+        CHECK_EQUAL("b:c", views[1]);
+    }
+}
+
+TEST(SplitWhitespaceAndLinesToOutputIterator)
+{
+    std::deque<std::string_view> words;
+    string_utils::split("  one two\tthree ", std::back_inserter(words));
+    CHECK_EQUAL(3U, words.size());
+    CHECK_EQUAL("three", words.back());
+
+    std::vector<std::string> lines;
+    string_utils::splitlines("one\r\ntwo\n", std::back_inserter(lines), true);
+    CHECK_EQUAL(2U, lines.size());
+    CHECK_EQUAL("one\r\n", lines[0]);
+}
+
+TEST(ReverseSplitToOutputIterator)
+{
+    std::vector<std::string_view> views;
+    string_utils::rsplit("a:b:c", ":", std::back_inserter(views), 1);
+    CHECK_EQUAL(2U, views.size());
+    CHECK_EQUAL("a:b", views[0]);
+    CHECK_EQUAL("c", views[1]);
+}
+
+TEST(SplitEachCanStopEarly)
+{
+    std::vector<std::string_view> seen;
+    const bool completed = string_utils::split_each("a,b,stop,c", ",", [&](std::string_view token)
+    {
+        seen.push_back(token);
+        return token != "stop";
+    });
+    CHECK(!completed);
+    CHECK_EQUAL(3U, seen.size());
+
+    int count = 0;
+    CHECK(string_utils::splitlines_each("1\n2\n3\n", [&](std::string_view) { ++count; }));
+    CHECK_EQUAL(3, count);
+
+    std::string joined;
+    string_utils::rsplit_each("a b  c", [&](std::string_view token) { joined.append(token); });
+    CHECK_EQUAL("abc", joined);
+    string_utils::rsplit_each("a-b-c", "-", [&](std::string_view token) { joined.append(token); }, 1);
+    CHECK_EQUAL("abca-bc", joined);
+}
+
+TEST(SplitLinesKeepsFinalUnterminatedLine)
+{
+    string_utils::string_list returned = string_utils::splitlines("1. One\n2. Two");
+    CHECK_EQUAL(2U, returned.size());
+    CHECK_EQUAL("2. Two", returned.back());
+    CHECK_EQUAL(1U, string_utils::splitlines("no newline").size());
+    CHECK(string_utils::splitlines("").empty());
+}
+
+TEST(SplitLinesTrailingCarriageReturn)
+{
+    string_utils::string_list returned = string_utils::splitlines("1. One\r", true);
+    CHECK_EQUAL(1U, returned.size());
+    CHECK_EQUAL("1. One\r", returned.front());
+
+    returned = string_utils::splitlines("\r\r\n\n");
+    CHECK_EQUAL(3U, returned.size());
+}
+
+TEST(SplitLinesAgreesWithFindFirstOf)
+{
+    std::string s;
+    for (int i = 0; i < 300; ++i)
+    {
+        s.append(i % 7, 'x');
+        s.append(i % 3 == 0 ? "\r\n" : i % 3 == 1 ? "\n" : "\r");
+    }
+    s.append("tail");
+
+    string_utils::string_view_list expected;
+    for (std::string_view rest(s); !rest.empty();)
+    {
+        std::string_view::size_type end = rest.find_first_of("\r\n");
+        end = end == std::string_view::npos ? rest.length() : end + (rest.compare(end, 2, "\r\n") == 0 ? 2 : 1);
+        expected.push_back(rest.substr(0, end));
+        rest.remove_prefix(end);
+    }
+    CHECK(expected == string_utils::splitlines_view(s, true));
+}
+
+TEST(LineReaderAgreesWithSplitLines)
+{
+    std::string text;
+    for (int i = 0; i < 200; ++i)
+    {
+        text.append(i % 11, 'x');
+        text.append(i % 3 == 0 ? "\r\n" : i % 3 == 1 ? "\n" : "\r");
+    }
+    text.append("unterminated");
+
+    for (std::size_t chunk_size = 1; chunk_size <= 17; ++chunk_size)
+    {
+        for (int keepends = 0; keepends < 2; ++keepends)
+        {
+            std::istringstream in(text);
+            string_utils::line_reader reader(in, keepends, chunk_size);
+            std::vector<std::string> lines;
+            std::string_view line;
+            while (reader.next(line))
+            {
+                lines.push_back(std::string(line));
+            }
+            const string_utils::string_list expected = string_utils::splitlines(text, keepends);
+            CHECK(std::vector<std::string>(expected.begin(), expected.end()) == lines);
+        }
+    }
+}
+
+TEST(LineReaderJoinsCrLfAcrossChunks)
+{
+    std::istringstream in("ab\r\ncd\r");
+    string_utils::line_reader reader(in, true, 3);
+    std::string_view line;
+    CHECK(reader.next(line));
+    CHECK_EQUAL("ab\r\n", line);
+    CHECK(reader.next(line));
+    CHECK_EQUAL("cd\r", line);
+    CHECK(!reader.next(line));
+}
+
+TEST(LineReaderFromFileDescriptor)
+{
+    int fds[2];
+    CHECK_EQUAL(0, ::pipe(fds));
+    const char text[] = "one\ntwo\r\nthree";
+    CHECK_EQUAL(static_cast<ssize_t>(sizeof text - 1), ::write(fds[1], text, sizeof text - 1));
+    ::close(fds[1]);
+
+    string_utils::line_reader reader(fds[0], false, 4);
+    std::string_view line;
+    std::vector<std::string> lines;
+    while (reader.next(line))
+    {
+        lines.push_back(std::string(line));
+    }
+    ::close(fds[0]);
+    CHECK_EQUAL(3U, lines.size());
+    CHECK_EQUAL("two", lines[1]);
+    CHECK_EQUAL("three", lines[2]);
+}
+
+TEST(MappedTextWorksWithViewFunctions)
+{
+    char path[] = "/tmp/t_string_utils.XXXXXX";
+    const int fd = ::mkstemp(path);
+    CHECK(fd >= 0);
+    const char text[] = "alpha,beta\ngamma,delta\nalpha";
+    CHECK_EQUAL(static_cast<ssize_t>(sizeof text - 1), ::write(fd, text, sizeof text - 1));
+    ::close(fd);
+
+    {
+        const string_utils::mapped_text mapped(path);
+        CHECK(mapped.mapped());
+        CHECK_EQUAL(std::string_view(text), mapped.view());
+        CHECK_EQUAL(2, string_utils::count(mapped, "alpha"));
+        CHECK_EQUAL(6, string_utils::find(mapped, "beta"));
+        CHECK_EQUAL(3U, string_utils::splitlines(mapped).size());
+        CHECK_EQUAL(3U, string_utils::split_view(mapped, ",").size());
+    }
+
+    CHECK_EQUAL(0, ::truncate(path, 0));
+    {
+        const string_utils::mapped_text empty(path);
+        CHECK(!empty.mapped());
+        CHECK(empty.view().empty());
+    }
+    ::unlink(path);
+}
+
+TEST(MappedTextFallsBackToReading)
+{
+    const string_utils::mapped_text device("/dev/null");
+    CHECK(!device.mapped());
+    CHECK(device.view().empty());
+    CHECK_THROW(string_utils::mapped_text("/nonexistent/t_string_utils"), std::system_error);
+}
+
+TEST(LinesRangeWithKeepEnds)
+{
+    std::vector<std::string_view> returned;
+    for (std::string_view line : string_utils::lines_range("1. One\r\n2. Two\n", true))
+    {
+        returned.push_back(line);
+    }
+    CHECK_EQUAL(2U, returned.size());
+    CHECK_EQUAL("1. One\r\n", returned[0]);
+    CHECK_EQUAL("2. Two\n", returned[1]);
+}
+
 TEST(StartsWithPositive)
 {
     CHECK_EQUAL(true, string_utils::startswith("contraband", "contra"));
@@ -837,6 +1730,24 @@ TEST(StartsWithDealWithExtraLongStrings)
     CHECK_EQUAL(false, string_utils::startswith("band", "bandit"));
 }
 
+TEST(StartsWithStopsAtEndOfView)
+{
+    const std::string_view contra("contraband", 4);
+    CHECK_EQUAL(false, string_utils::startswith(contra, "contra"));
+    CHECK_EQUAL(true, string_utils::startswith(contra, "nt", 2, 100));
+    CHECK_EQUAL(false, string_utils::startswith(contra, "ntr", 2, 100));
+    CHECK_EQUAL(false, string_utils::startswith(contra, "", 5));
+}
+
+TEST(EndsWithStopsAtEndOfView)
+{
+    const std::string_view abc("abcdef", 3);
+    CHECK_EQUAL(true, string_utils::endswith(abc, "abc", 0, 100));
+    CHECK_EQUAL(false, string_utils::endswith(abc, "abcd", 0, 100));
+    CHECK_EQUAL(true, string_utils::endswith(abc, "bc", 1, 100));
+    CHECK_EQUAL(false, string_utils::endswith(abc, "", 5));
+}
+
 TEST(StartswithStartMidStringPositive)
 {
     CHECK_EQUAL(true, string_utils::startswith("abcdef", "def", 3));
@@ -862,16 +1773,136 @@ TEST(StripBothEnds)
     CHECK_EQUAL("trimmed", string_utils::strip("    trimmed    "));
 }
 
+TEST(StripViewBothEnds)
+{
+    CHECK_EQUAL("trimmed", string_utils::strip_view("    trimmed    "));
+}
+
+TEST(StripViewOnlySpace)
+{
+    CHECK(string_utils::strip_view(" \t\r\n").empty());
+}
+
+TEST(StripWithCharset)
+{
+    constexpr string_utils::charset punctuation(".,!?");
+    static_assert(punctuation.contains('!') && !punctuation.contains('a'), "charset is usable at compile time");
+    CHECK_EQUAL("Hello, world", string_utils::strip("..Hello, world!?", punctuation));
+    CHECK_EQUAL("Hello, world!?", string_utils::lstrip("..Hello, world!?", punctuation));
+    CHECK_EQUAL("..Hello, world", string_utils::rstrip("..Hello, world!?", punctuation));
+    CHECK(string_utils::strip_view("!!!", punctuation).empty());
+    CHECK_EQUAL("xyx", string_utils::strip("\xe9xyx\xe9", string_utils::charset(std::string_view("\xe9"))));
+}
+
+TEST(StripInPlaceWithCharset)
+{
+    std::string s("--a-b--");
+    string_utils::strip_inplace(s, "-");
+    CHECK_EQUAL("a-b", s);
+}
+
+TEST(SplitAny)
+{
+    const string_utils::string_list returned = string_utils::split_any("a,b;;c", ",;");
+    CHECK_EQUAL(4U, returned.size());
+    CHECK_EQUAL("a", returned.front());
+    CHECK_EQUAL("c", returned.back());
+
+    const string_utils::string_view_list limited = string_utils::split_any_view("a,b;c", ",;", 1);
+    CHECK_EQUAL(2U, limited.size());
+    CHECK_EQUAL("b;c", limited.back());
+
+    CHECK_EQUAL(1U, string_utils::split_any("abc", ",").size());
+    CHECK_EQUAL(2U, string_utils::split_any("abc,", ",").size());
+    CHECK_THROW(string_utils::split_any("abc", ""), string_utils::value_error);
+}
+
 TEST(SwapCase)
 {
     CHECK_EQUAL("s.SWAPCASE() -> STRING", string_utils::swapcase("S.swapcase() -> string"));
 }
 
+TEST(SwapCaseEveryByte)
+{
+    const std::string s = every_byte_twice();
+    std::string expected;
+    for (std::string::const_iterator current = s.begin(); current != s.end(); ++current)
+    {
+        const unsigned char ch = *current;
+        expected.push_back(::islower(ch) ? ::toupper(ch) : ::isupper(ch) ? ::tolower(ch) : ch);
+    }
+    CHECK(expected == string_utils::swapcase(s));
+}
+
+TEST(TableFormatter)
+{
+    std::vector<string_utils::column_t> columns(4);
+    columns[0].width = 6;
+    columns[1].width = 5;
+    columns[1].alignment = string_utils::align_right;
+    columns[2].width = 7;
+    columns[2].alignment = string_utils::align_center;
+    columns[2].fill = '*';
+    columns[3].width = 4;
+    columns[3].zero_pad = true;
+
+    string_utils::table_formatter table(columns, "|");
+    table.add_row({ "ab", "cd", "ef", "7" });
+    table.add_row({ "toolongcell", "x" });
+    CHECK_EQUAL(string_utils::ljust("ab", 6) + "|" + string_utils::rjust("cd", 5) + "|"
+                + string_utils::center("ef", 7, '*') + "|" + string_utils::zfill("7", 4) + "\n"
+                + "toolongcell|    x|*******|0000\n",
+                table.str());
+    CHECK_THROW(table.add_row({ "1", "2", "3", "4", "5" }), string_utils::value_error);
+}
+
+TEST(TableFormatterUsableAfterExtraCells)
+{
+    std::vector<string_utils::column_t> columns(2);
+    columns[0].width = 4;
+    columns[1].width = 4;
+
+    string_utils::table_formatter table(columns);
+    table.add_row({ "x", "y" });
+    CHECK_THROW(table.add_row({ "1", "2", "3" }), string_utils::value_error);
+    table.add_row({ "p", "q" });
+    CHECK_EQUAL("x    y   \np    q   \n", table.str());
+}
+
+TEST(TableFormatterAutoWidth)
+{
+    std::vector<string_utils::column_t> columns(2);
+    columns[0].auto_width = true;
+    columns[1].auto_width = true;
+    columns[1].width = 3;
+    columns[1].alignment = string_utils::align_right;
+
+    std::vector<std::vector<std::string> > rows(2);
+    rows[0].push_back("name");
+    rows[0].push_back("n");
+    rows[1].push_back("longer name");
+    rows[1].push_back("1");
+
+    string_utils::table_formatter table(columns);
+    table.fit(rows);
+    CHECK_EQUAL(11, table.columns()[0].width);
+    CHECK_EQUAL(3, table.columns()[1].width);
+    table.add_rows(rows);
+    CHECK_EQUAL("name          n\nlonger name   1\n", table.str());
+}
+
 TEST(TitleCase)
 {
     CHECK_EQUAL("Wall Street", string_utils::title("WALL street"));
 }
 
+TEST(TitleCaseInPlace)
+{
+    std::string s("WALL street");
+    string_utils::title_inplace(s);
+    CHECK_EQUAL("Wall Street", s);
+}
+
 TEST(Translate)
 {
     const char* const translation_table =
@@ -893,6 +1924,68 @@ TEST(TranslateAndDeleteChars)
     CHECK_EQUAL("______", string_utils::translate("xxx!?xxx", translation_table, delete_chars));
 }
 
+TEST(TranslateInPlace)
+{
+    std::string translation_table(256, '_');
+    translation_table['x'] = 'y';
+    translation_table[0xe9] = 'e';
+    std::string s("x!?x\xe9");
+    string_utils::translate_inplace(s, translation_table, "?!");
+    CHECK_EQUAL("yye", s);
+}
+
+TEST(MakeTrans)
+{
+    const string_utils::translation rot13 = string_utils::maketrans("abcdefghijklmnopqrstuvwxyz",
+                                                                    "nopqrstuvwxyzabcdefghijklm");
+    CHECK_EQUAL("uryyb, jbeyq", string_utils::translate("hello, world", rot13));
+    CHECK_EQUAL("hello, world", string_utils::translate("uryyb, jbeyq", rot13));
+}
+
+TEST(MakeTransWithDeleteChars)
+{
+    const string_utils::translation table = string_utils::maketrans("ab", "AB", "c\xe9");
+    CHECK(table.deletes('\xe9'));
+    CHECK(!table.deletes('a'));
+    CHECK_EQUAL('B', table.map('b'));
+    CHECK_EQUAL("ABAB", string_utils::translate("acb\xe9" "cab", table));
+
+    std::string s("ccc\xe9");
+    string_utils::translate_inplace(s, table);
+    CHECK_EQUAL("", s);
+}
+
+TEST(MakeTransAgreesOnEveryByte)
+{
+    std::string from, to, delete_chars;
+    for (int i = 0; i < 256; ++i)
+    {
+        from.push_back(static_cast<char>(i));
+        to.push_back(static_cast<char>(255 - i));
+        if (i % 3 == 0)
+        {
+            delete_chars.push_back(static_cast<char>(i));
+        }
+    }
+    const std::string input = every_byte_twice();
+    std::string expected;
+    for (std::string::const_iterator current = input.begin(); current != input.end(); ++current)
+    {
+        const unsigned char byte = *current;
+        if (byte % 3 != 0)
+        {
+            expected.push_back(static_cast<char>(255 - byte));
+        }
+    }
+    CHECK(expected == string_utils::translate(input, string_utils::maketrans(from, to, delete_chars)));
+    CHECK(expected == string_utils::translate(input, to, delete_chars));
+}
+
+TEST(MakeTransThrowsOnLengthMismatch)
+{
+    CHECK_THROW(string_utils::maketrans("abc", "ab"), string_utils::value_error);
+}
+
 TEST(TranslateThrowsWhenTableIsWrongSize)
 {
     CHECK_THROW(string_utils::translate("Some String", "Small Table"), string_utils::value_error);
@@ -915,6 +2008,23 @@ TEST(Upper)
     CHECK_EQUAL("UPPERCASE", string_utils::upper("uppercase"));
 }
 
+TEST(UpperEveryByte)
+{
+    const std::string s = every_byte_twice();
+    std::string expected;
+    for (std::string::const_iterator current = s.begin(); current != s.end(); ++current)
+    {
+        expected.push_back(::toupper(static_cast<unsigned char>(*current)));
+    }
+    CHECK(expected == string_utils::upper(s));
+}
+
+TEST(UpperLongMixedString)
+{
+    CHECK_EQUAL("THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG, éCLAIR @[`{",
+                string_utils::upper("The quick brown fox jumps over the lazy dog, éclair @[`{"));
+}
+
 TEST(ZeroFill)
 {
     CHECK_EQUAL("00001", string_utils::zfill("1", 5));
@@ -925,6 +2035,246 @@ TEST(ZeroFillDoesNotTruncate)
     CHECK_EQUAL("123456", string_utils::zfill("123456", 5));
 }
 
+TEST(ConsumingChainReusesBuffer)
+{
+    std::string s("  Some MIXED case text, long enough to live on the heap  ");
+    const char* const buffer = s.data();
+    const std::string result = string_utils::strip(string_utils::lower(std::move(s)));
+    CHECK_EQUAL("some mixed case text, long enough to live on the heap", result);
+    CHECK(buffer == result.data());
+}
+
+TEST(InPlaceTransforms)
+{
+    std::string s("\t Hello, World \n");
+    string_utils::rstrip_inplace(s);
+    CHECK_EQUAL("\t Hello, World", s);
+    string_utils::lstrip_inplace(s);
+    CHECK_EQUAL("Hello, World", s);
+    string_utils::swapcase_inplace(s);
+    CHECK_EQUAL("hELLO, wORLD", s);
+    string_utils::upper_inplace(s);
+    CHECK_EQUAL("HELLO, WORLD", s);
+    string_utils::lower_inplace(s);
+    CHECK_EQUAL("hello, world", s);
+    string_utils::strip_inplace(s);
+    CHECK_EQUAL("hello, world", s);
+}
+
+TEST(PmrResultsLiveInTheGivenResource)
+{
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer, std::pmr::null_memory_resource());
+
+    const string_utils::pmr::string_list split = string_utils::pmr::split("a fairly long first field:b:c", ":", &arena);
+    CHECK_EQUAL(3U, split.size());
+    CHECK_EQUAL("a fairly long first field", split.front());
+    CHECK(split.get_allocator().resource() == &arena);
+    CHECK(split.front().get_allocator().resource() == &arena);
+
+    const string_utils::pmr::string_list rsplit = string_utils::pmr::rsplit("a:b:c", ":", &arena, 1);
+    CHECK_EQUAL("a:b", rsplit.front());
+    CHECK_EQUAL(2U, string_utils::pmr::splitlines("1\n2\n", &arena).size());
+    CHECK_EQUAL(3U, string_utils::pmr::split(" x y  z ", &arena).size());
+
+    const string_utils::pmr::partition_t partitioned = string_utils::pmr::partition("key=value", "=", &arena);
+    CHECK_EQUAL("key", partitioned.head);
+    CHECK_EQUAL("value", partitioned.tail);
+    CHECK(partitioned.tail.get_allocator().resource() == &arena);
+    CHECK_EQUAL("a=b", string_utils::pmr::rpartition("a=b=c", "=", &arena).head);
+
+    const string_utils::pmr::string replaced = string_utils::pmr::replace("one two one two one two one two", "two", "three", &arena);
+    CHECK_EQUAL("one three one three one three one three", replaced);
+    CHECK(replaced.get_allocator().resource() == &arena);
+    CHECK_EQUAL("a-b", string_utils::pmr::replace("a b", string_utils::searcher(" "), "-", &arena));
+
+    std::vector<int> numbers;
+    numbers.push_back(1);
+    numbers.push_back(22);
+    CHECK_EQUAL("1, 22", string_utils::pmr::join(", ", numbers, &arena));
+    CHECK_EQUAL("a fairly long first field:b:c", string_utils::pmr::join(":", split, &arena));
+    CHECK_EQUAL("", string_utils::pmr::join(":", std::vector<std::string>(), &arena));
+}
+
+TEST(PmrTransformsLiveInTheGivenResource)
+{
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer, std::pmr::null_memory_resource());
+
+    const string_utils::pmr::string uppercased = string_utils::pmr::upper("a fairly long mixed-Case string", &arena);
+    CHECK_EQUAL("A FAIRLY LONG MIXED-CASE STRING", uppercased);
+    CHECK(uppercased.get_allocator().resource() == &arena);
+    CHECK_EQUAL("mixed", string_utils::pmr::lower("MiXeD", &arena));
+    CHECK_EQUAL("mIxEd", string_utils::pmr::swapcase("MiXeD", &arena));
+    CHECK_EQUAL("Hello World", string_utils::pmr::title("hELLO wORLD", &arena));
+
+    CHECK_EQUAL("x  ", string_utils::pmr::lstrip("  x  ", &arena));
+    CHECK_EQUAL("  x", string_utils::pmr::rstrip("  x  ", &arena));
+    CHECK_EQUAL("x", string_utils::pmr::strip("--x--", &arena, "-"));
+
+    CHECK_EQUAL("ab...", string_utils::pmr::ljust("ab", 5, &arena, '.'));
+    CHECK_EQUAL("   ab", string_utils::pmr::rjust("ab", 5, &arena));
+    CHECK_EQUAL("*ab**", string_utils::pmr::center("ab", 5, &arena, '*'));
+    CHECK_EQUAL("00042", string_utils::pmr::zfill("42", 5, &arena));
+    CHECK_EQUAL("toolong", string_utils::pmr::center("toolong", 3, &arena));
+
+    CHECK_EQUAL("a   bc  d\n    e", string_utils::pmr::expandtabs("a\tbc\td\n\te", &arena, 4));
+    const string_utils::translation table = string_utils::maketrans("abc", "xyz", "-");
+    CHECK_EQUAL("x-y-z", string_utils::pmr::translate("a-b-c", string_utils::maketrans("abc", "xyz"), &arena));
+    CHECK_EQUAL("xyz", string_utils::pmr::translate("a-b-c", table, &arena));
+}
+
+namespace {
+
+std::string pseudo_random_text(std::size_t size, const char* alphabet, unsigned seed)
+{
+    const std::size_t letters = std::strlen(alphabet);
+    std::string s;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        s.push_back(alphabet[(seed >> 16) % letters]);
+    }
+    return s;
+}
+
+}
+
+TEST(CountEmptySubstring)
+{
+    CHECK_EQUAL(4, string_utils::count("abc", ""));
+}
+
+TEST(ParallelSearchAgreesWithSerial)
+{
+    string_utils::thread_pool pool(4, 7);
+    const char* const needles[] = { "a", "aa", "aba", "abab", "bb", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "c" };
+    for (unsigned seed = 1; seed < 20; ++seed)
+    {
+        const std::string s = pseudo_random_text(seed * 11, seed % 2 ? "ab" : "aaab", seed);
+        for (const char* needle : needles)
+        {
+            CHECK_EQUAL(string_utils::count(s, needle), string_utils::count(pool, s, needle));
+            CHECK_EQUAL(string_utils::find(s, needle), string_utils::find(pool, s, needle));
+            CHECK_EQUAL(string_utils::rfind(s, needle), string_utils::rfind(pool, s, needle));
+            CHECK_EQUAL(string_utils::count(s, needle), string_utils::count(pool, s, string_utils::searcher(needle)));
+        }
+    }
+    CHECK_EQUAL(11, string_utils::count(pool, std::string(10, 'x'), ""));
+}
+
+TEST(ParallelReplaceAgreesWithSerial)
+{
+    string_utils::thread_pool pool(3, 5);
+    const char* const olds[] = { "a", "aa", "aba", "bab" };
+    const char* const withs[] = { "", "X", "XYZW" };
+    const std::ptrdiff_t counts[] = { 0, 1, 3, 7, -2, string_utils::max_count };
+    for (unsigned seed = 1; seed < 12; ++seed)
+    {
+        const std::string s = pseudo_random_text(seed * 13, "ab", seed);
+        for (const char* old : olds)
+        {
+            for (const char* with : withs)
+            {
+                for (std::ptrdiff_t count : counts)
+                {
+                    CHECK_EQUAL(string_utils::replace(s, old, with, count), string_utils::replace(pool, s, old, with, count));
+                }
+            }
+        }
+    }
+    CHECK_EQUAL("-a-b-", string_utils::replace(pool, "ab", "", "-"));
+}
+
+TEST(ParallelTransformsAgreeWithSerial)
+{
+    string_utils::thread_pool pool(4, 3);
+    const std::string s = every_byte_twice() + "Mixed Case TEXT, with punctuation!";
+    CHECK(string_utils::upper(s) == string_utils::upper(pool, s));
+    CHECK(string_utils::lower(s) == string_utils::lower(pool, s));
+
+    const string_utils::translation table = string_utils::maketrans("aeiou", "AEIOU", "x, ");
+    CHECK(string_utils::translate(s, table) == string_utils::translate(pool, s, table));
+    CHECK_EQUAL("", string_utils::translate(pool, "", table));
+}
+
+TEST(ThreadPoolRethrows)
+{
+    string_utils::thread_pool pool(4);
+    CHECK_THROW(pool.run(16, [](std::size_t i) { if (i == 9) throw string_utils::value_error("nine"); }), string_utils::value_error);
+
+    std::atomic<int> calls(0);
+    pool.run(100, [&](std::size_t) { ++calls; });
+    CHECK_EQUAL(100, calls.load());
+}
+
+TEST(ThreadPoolNestedRun)
+{
+    string_utils::thread_pool pool(2, 1);
+    std::atomic<int> calls(0);
+    pool.run(8, [&](std::size_t)
+    {
+        pool.run(8, [&](std::size_t) { ++calls; });
+    });
+    CHECK_EQUAL(64, calls.load());
+}
+
+TEST(BatchApplyPipeline)
+{
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 5000; ++i)
+    {
+        inputs.push_back("  Key-" + std::to_string(i) + " = VALUE  ");
+    }
+    std::vector<string_utils::string_list> outputs(inputs.size());
+
+    string_utils::thread_pool pool(4);
+    string_utils::batch::apply(pool, inputs, outputs,
+                               string_utils::batch::pipeline(string_utils::batch::strip(),
+                                                             string_utils::batch::lower(),
+                                                             string_utils::batch::replace(" = ", "="),
+                                                             string_utils::batch::split("=")),
+                               64);
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        CHECK(string_utils::split(string_utils::replace(string_utils::lower(string_utils::strip(inputs[i])), " = ", "="), "=") == outputs[i]);
+    }
+    CHECK_EQUAL("key-4999", outputs.back().front());
+}
+
+TEST(BatchApplySpans)
+{
+    const std::string_view inputs[] = { "Alpha", "BETA", "gamma" };
+    std::string outputs[3];
+    string_utils::thread_pool pool(2);
+    string_utils::batch::apply(pool,
+                               string_utils::batch::span<const std::string_view>(inputs, 3),
+                               string_utils::batch::span<std::string>(outputs, 3),
+                               string_utils::batch::upper(), 1);
+    CHECK_EQUAL("ALPHA", outputs[0]);
+    CHECK_EQUAL("GAMMA", outputs[2]);
+
+    CHECK_THROW(string_utils::batch::apply(pool,
+                                           string_utils::batch::span<const std::string_view>(inputs, 3),
+                                           string_utils::batch::span<std::string>(outputs, 2),
+                                           string_utils::batch::upper()),
+                string_utils::value_error);
+}
+
+TEST(BatchApplyOpUsesSamePool)
+{
+    const std::vector<std::string> inputs(16, std::string(4096, 'a'));
+    std::vector<std::ptrdiff_t> outputs(inputs.size());
+    string_utils::thread_pool pool(2, 64);
+    string_utils::batch::apply(pool, inputs, outputs,
+                               [&](const std::string& s) { return string_utils::count(pool, s, "a"); },
+                               1);
+    for (std::size_t i = 0; i < outputs.size(); ++i)
+    {
+        CHECK_EQUAL(4096, outputs[i]);
+    }
+}
+
 int main()
 {
     return UnitTest::RunAllTests();